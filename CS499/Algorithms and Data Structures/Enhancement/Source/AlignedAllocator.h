@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/***********************************************************
+ *  AlignedAllocator
+ *
+ *  Standard allocator whose blocks start on an Alignment
+ *  byte boundary, so a std::vector of floats can be read
+ *  with aligned SIMD loads from its first element.
+ ***********************************************************/
+template <typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count)
+    {
+        // Over-allocate and keep the raw pointer just before the aligned block
+        void* raw = ::operator new(count * sizeof(T) + Alignment + sizeof(void*));
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* block, size_t)
+    {
+        ::operator delete(reinterpret_cast<void**>(block)[-1]);
+    }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
@@ -0,0 +1,415 @@
+#include "BVH.h"
+#include <algorithm>
+
+const uint32_t BVH::kInvalidIndex;
+const uint32_t BVH::kInternalNode;
+const uint32_t BVH::kPendingSlot;
+const int BVH::kBinCount;
+const uint32_t BVH::kMaxLeafSize;
+const int BVH::kMaxSahDepth;
+const size_t BVH::kMinPendingRebuild;
+
+namespace {
+    // Cost of visiting a node relative to testing one sphere
+    const float kTraversalCost = 1.0f;
+
+    // Half the surface area of a box; only ratios matter to the SAH
+    float halfArea(const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 extent = max - min;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+
+    void includeSphere(glm::vec3& boundsMin, glm::vec3& boundsMax, const SceneObject& obj) {
+        boundsMin = glm::min(boundsMin, obj.position - glm::vec3(obj.boundingRadius));
+        boundsMax = glm::max(boundsMax, obj.position + glm::vec3(obj.boundingRadius));
+    }
+
+    // Split key: a center coordinate for axes 0-2, the radius for axis 3
+    float splitKey(const SceneObject& obj, int axis) {
+        return axis < 3 ? obj.position[axis] : obj.boundingRadius;
+    }
+
+    bool insideBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+        return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+    }
+
+    struct Bin {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        uint32_t count;
+    };
+}
+
+BVH::BVH()
+    : m_objectCount(0) {
+}
+
+void BVH::clear() {
+    m_nodes.clear();
+    m_parents.clear();
+    m_objects.clear();
+    m_leafOf.clear();
+    m_pending.clear();
+    m_slots.clear();
+    m_objectCount = 0;
+}
+
+void BVH::build(const std::vector<SceneObject>& objects, int) {
+    clear();
+    if (objects.empty())
+        return;
+    m_objects = objects;
+    m_leafOf.resize(objects.size());
+    // A binary tree with at least one object per leaf has fewer than 2n nodes
+    m_nodes.reserve(2 * objects.size());
+    m_parents.reserve(2 * objects.size());
+    m_nodes.resize(1);
+    m_parents.push_back(kInvalidIndex);
+    buildNode(0, 0, static_cast<uint32_t>(objects.size()), 0);
+
+    m_slots.reserve(objects.size());
+    for (uint32_t i = 0; i < m_objects.size(); ++i) m_slots[m_objects[i].id] = i;
+    m_objectCount = objects.size();
+}
+
+void BVH::buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth) {
+    Node node;
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint32_t i = first; i < first + count; ++i) includeSphere(node.boundsMin, node.boundsMax, m_objects[i]);
+
+    uint32_t mid = splitObjects(node, first, count, depth);
+    if (mid == first + count) {
+        node.first = first;
+        node.count = count;
+        m_nodes[nodeIndex] = node;
+        for (uint32_t i = first; i < first + count; ++i) m_leafOf[i] = nodeIndex;
+        return;
+    }
+
+    uint32_t left = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.resize(left + 2);
+    m_parents.push_back(nodeIndex);
+    m_parents.push_back(nodeIndex);
+    node.first = left;
+    node.count = kInternalNode;
+    m_nodes[nodeIndex] = node;
+    buildNode(left, first, mid - first, depth + 1);
+    buildNode(left + 1, mid, first + count - mid, depth + 1);
+}
+
+uint32_t BVH::splitObjects(const Node& node, uint32_t first, uint32_t count, int depth) {
+    const uint32_t end = first + count;
+    if (count <= 2)
+        return end;
+
+    // Range of each split key: the three center coordinates and the radius
+    glm::vec4 keyMin(std::numeric_limits<float>::max());
+    glm::vec4 keyMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = first; i < end; ++i) {
+        glm::vec4 key(m_objects[i].position, m_objects[i].boundingRadius);
+        keyMin = glm::min(keyMin, key);
+        keyMax = glm::max(keyMax, key);
+    }
+    const glm::vec4 extent = keyMax - keyMin;
+
+    // Bin along each key and sweep the planes between bins. Binning by radius lets
+    // SAH pull a few large spheres away from many small ones that share their space.
+    int bestAxis = -1;
+    int bestPlane = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 4 && depth < kMaxSahDepth; ++axis) {
+        if (!(extent[axis] > 0.0f))
+            continue;
+        const float scale = kBinCount / extent[axis];
+        Bin bins[kBinCount];
+        for (auto& bin : bins) {
+            bin.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            bin.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+            bin.count = 0;
+        }
+        for (uint32_t i = first; i < end; ++i) {
+            int b = std::min(kBinCount - 1, static_cast<int>((splitKey(m_objects[i], axis) - keyMin[axis]) * scale));
+            ++bins[b].count;
+            includeSphere(bins[b].boundsMin, bins[b].boundsMax, m_objects[i]);
+        }
+
+        // rightCost[p] and rightCount[p] cover bins p and above
+        float rightCost[kBinCount];
+        uint32_t rightCount[kBinCount];
+        glm::vec3 sideMin(std::numeric_limits<float>::max());
+        glm::vec3 sideMax(-std::numeric_limits<float>::max());
+        uint32_t sideCount = 0;
+        for (int b = kBinCount - 1; b > 0; --b) {
+            sideMin = glm::min(sideMin, bins[b].boundsMin);
+            sideMax = glm::max(sideMax, bins[b].boundsMax);
+            sideCount += bins[b].count;
+            rightCount[b] = sideCount;
+            rightCost[b] = sideCount > 0 ? sideCount * halfArea(sideMin, sideMax) : 0.0f;
+        }
+        sideMin = glm::vec3(std::numeric_limits<float>::max());
+        sideMax = glm::vec3(-std::numeric_limits<float>::max());
+        sideCount = 0;
+        for (int plane = 1; plane < kBinCount; ++plane) {
+            sideMin = glm::min(sideMin, bins[plane - 1].boundsMin);
+            sideMax = glm::max(sideMax, bins[plane - 1].boundsMax);
+            sideCount += bins[plane - 1].count;
+            if (sideCount == 0 || rightCount[plane] == 0)
+                continue;
+            float cost = sideCount * halfArea(sideMin, sideMax) + rightCost[plane];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestPlane = plane;
+            }
+        }
+    }
+
+    // Splitting pays when a traversal plus the two children's expected tests beats testing every sphere here
+    const float area = halfArea(node.boundsMin, node.boundsMax);
+    const bool sahSplits = bestAxis >= 0 && kTraversalCost * area + bestCost < count * area;
+    if (!sahSplits && count <= kMaxLeafSize)
+        return end;
+
+    SceneObject* objects = m_objects.data();
+    if (bestAxis >= 0) {
+        const float scale = kBinCount / extent[bestAxis];
+        const float axisMin = keyMin[bestAxis];
+        const int axis = bestAxis;
+        const int plane = bestPlane;
+        SceneObject* mid = std::partition(objects + first, objects + end, [=](const SceneObject& obj) {
+            return std::min(kBinCount - 1, static_cast<int>((splitKey(obj, axis) - axisMin) * scale)) < plane;
+        });
+        return static_cast<uint32_t>(mid - objects);
+    }
+
+    // Too deep for SAH or every center coincides: halve by count so depth stays logarithmic
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    const uint32_t mid = first + count / 2;
+    std::nth_element(objects + first, objects + mid, objects + end, [axis](const SceneObject& a, const SceneObject& b) {
+        return a.position[axis] < b.position[axis];
+    });
+    return mid;
+}
+
+void BVH::refit(uint32_t leafIndex) {
+    Node& leaf = m_nodes[leafIndex];
+    leaf.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    leaf.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i) includeSphere(leaf.boundsMin, leaf.boundsMax, m_objects[i]);
+
+    for (uint32_t n = m_parents[leafIndex]; n != kInvalidIndex; n = m_parents[n]) {
+        Node& node = m_nodes[n];
+        const Node& left = m_nodes[node.first];
+        const Node& right = m_nodes[node.first + 1];
+        glm::vec3 boundsMin = glm::min(left.boundsMin, right.boundsMin);
+        glm::vec3 boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        // Boxes above an unchanged box are unchanged too
+        if (boundsMin == node.boundsMin && boundsMax == node.boundsMax)
+            break;
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+    }
+}
+
+void BVH::rebuild() {
+    std::vector<SceneObject> objects;
+    objects.reserve(m_objectCount);
+    for (const auto& node : m_nodes) {
+        if (isLeaf(node))
+            objects.insert(objects.end(), m_objects.begin() + node.first, m_objects.begin() + node.first + node.count);
+    }
+    objects.insert(objects.end(), m_pending.begin(), m_pending.end());
+    build(objects);
+}
+
+void BVH::insert(const SceneObject& obj) {
+    remove(obj.id);
+    m_slots[obj.id] = static_cast<uint32_t>(m_pending.size()) | kPendingSlot;
+    m_pending.push_back(obj);
+    ++m_objectCount;
+    if (m_pending.size() > std::max(kMinPendingRebuild, (m_objectCount - m_pending.size()) / 8))
+        rebuild();
+}
+
+void BVH::removePending(uint32_t index) {
+    if (index != m_pending.size() - 1) {
+        m_pending[index] = m_pending.back();
+        m_slots[m_pending[index].id] = index | kPendingSlot;
+    }
+    m_pending.pop_back();
+}
+
+void BVH::remove(int objectId) {
+    auto it = m_slots.find(objectId);
+    if (it == m_slots.end())
+        return;
+    uint32_t slot = it->second;
+    m_slots.erase(it);
+    --m_objectCount;
+    if (slot & kPendingSlot) {
+        removePending(slot & ~kPendingSlot);
+        return;
+    }
+
+    // Swap-and-pop within the leaf's slice; the freed slot stays unused until the next build
+    uint32_t leafIndex = m_leafOf[slot];
+    Node& leaf = m_nodes[leafIndex];
+    uint32_t last = leaf.first + leaf.count - 1;
+    if (slot != last) {
+        m_objects[slot] = m_objects[last];
+        m_slots[m_objects[slot].id] = slot;
+    }
+    --leaf.count;
+    refit(leafIndex);
+}
+
+bool BVH::update(int objectId, const glm::vec3& newPosition, float newRadius) {
+    auto it = m_slots.find(objectId);
+    if (it == m_slots.end())
+        return false;
+    uint32_t slot = it->second;
+    SceneObject& obj = (slot & kPendingSlot) ? m_pending[slot & ~kPendingSlot] : m_objects[slot];
+    obj.position = newPosition;
+    obj.boundingRadius = newRadius;
+    if (!(slot & kPendingSlot))
+        refit(m_leafOf[slot]);
+    return true;
+}
+
+void BVH::query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const {
+    for (const auto& obj : m_pending) {
+        if (insideBox(obj.position, min, max)) results.push_back(obj.id);
+    }
+    if (!m_nodes.empty())
+        queryNode(0, min, max, results);
+}
+
+void BVH::queryNode(uint32_t nodeIndex, const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const {
+    const Node& node = m_nodes[nodeIndex];
+    const glm::vec3& nodeMin = node.boundsMin;
+    const glm::vec3& nodeMax = node.boundsMax;
+    if (!hasBounds(node) || nodeMax.x < min.x || nodeMin.x > max.x || nodeMax.y < min.y || nodeMin.y > max.y || nodeMax.z < min.z || nodeMin.z > max.z)
+        return;
+    if (isLeaf(node)) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (insideBox(m_objects[i].position, min, max)) results.push_back(m_objects[i].id);
+        }
+        return;
+    }
+    // Every center lies inside its node's box
+    if (insideBox(nodeMin, min, max) && insideBox(nodeMax, min, max)) {
+        collectAll(nodeIndex, results);
+        return;
+    }
+    queryNode(node.first, min, max, results);
+    queryNode(node.first + 1, min, max, results);
+}
+
+void BVH::queryFrustum(const Frustum& frustum, std::vector<int>& results) const {
+    for (const auto& obj : m_pending) {
+        if (frustum.intersectsSphere(obj.position, obj.boundingRadius)) results.push_back(obj.id);
+    }
+    if (!m_nodes.empty())
+        queryFrustumNode(0, frustum, results);
+}
+
+void BVH::queryFrustumNode(uint32_t nodeIndex, const Frustum& frustum, std::vector<int>& results) const {
+    const Node& node = m_nodes[nodeIndex];
+    if (!hasBounds(node))
+        return;
+    Frustum::Containment containment = frustum.classifyBox(node.boundsMin, node.boundsMax);
+    if (containment == Frustum::Outside)
+        return;
+    if (containment == Frustum::Inside) {
+        collectAll(nodeIndex, results);
+        return;
+    }
+    if (isLeaf(node)) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (frustum.intersectsSphere(m_objects[i].position, m_objects[i].boundingRadius)) results.push_back(m_objects[i].id);
+        }
+        return;
+    }
+    queryFrustumNode(node.first, frustum, results);
+    queryFrustumNode(node.first + 1, frustum, results);
+}
+
+void BVH::collectAll(uint32_t nodeIndex, std::vector<int>& results) const {
+    const Node& node = m_nodes[nodeIndex];
+    if (isLeaf(node)) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) results.push_back(m_objects[i].id);
+        return;
+    }
+    collectAll(node.first, results);
+    collectAll(node.first + 1, results);
+}
+
+bool BVH::raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, float maxDistance) const {
+    float length = glm::length(direction);
+    if (length <= 0.0f)
+        return false;
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = direction / length;
+    ray.inverseDirection = 1.0f / ray.direction;
+
+    RayHit best = { -1, maxDistance };
+    bool found = false;
+    for (const auto& obj : m_pending) {
+        float distance;
+        if (IntersectRaySphere(ray.origin, ray.direction, obj.position, obj.boundingRadius, best.distance, distance)
+            && (!found || distance < best.distance)) {
+            best.id = obj.id;
+            best.distance = distance;
+            found = true;
+        }
+    }
+    float entry;
+    if (!m_nodes.empty() && hasBounds(m_nodes[0])
+        && IntersectRayBox(ray.origin, ray.inverseDirection, m_nodes[0].boundsMin, m_nodes[0].boundsMax, best.distance, entry))
+        raycastNode(0, ray, best, found);
+    if (found)
+        hit = best;
+    return found;
+}
+
+void BVH::raycastNode(uint32_t nodeIndex, const Ray& ray, RayHit& best, bool& found) const {
+    const Node& node = m_nodes[nodeIndex];
+    if (isLeaf(node)) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            float distance;
+            if (IntersectRaySphere(ray.origin, ray.direction, m_objects[i].position, m_objects[i].boundingRadius, best.distance, distance)
+                && (!found || distance < best.distance)) {
+                best.id = m_objects[i].id;
+                best.distance = distance;
+                found = true;
+            }
+        }
+        return;
+    }
+
+    // Nearer child first; the other is skipped once it starts beyond the best hit
+    uint32_t children[2] = { node.first, node.first + 1 };
+    float entries[2] = { 0.0f, 0.0f };
+    bool enters[2];
+    for (int c = 0; c < 2; ++c) {
+        const Node& child = m_nodes[children[c]];
+        enters[c] = hasBounds(child) && IntersectRayBox(ray.origin, ray.inverseDirection, child.boundsMin, child.boundsMax, best.distance, entries[c]);
+    }
+    if (enters[0] && enters[1] && entries[1] < entries[0]) {
+        std::swap(children[0], children[1]);
+        std::swap(entries[0], entries[1]);
+    } else if (!enters[0]) {
+        children[0] = children[1];
+        entries[0] = entries[1];
+        enters[0] = enters[1];
+        enters[1] = false;
+    }
+    if (enters[0])
+        raycastNode(children[0], ray, best, found);
+    if (enters[1] && entries[1] <= best.distance)
+        raycastNode(children[1], ray, best, found);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "SpatialIndex.h"
+
+/***********************************************************
+ *  BVH
+ *
+ *  Bounding volume hierarchy over the objects' bounding
+ *  spheres. The build bins sphere centers into a fixed
+ *  number of buckets per axis and splits where the surface
+ *  area heuristic (SAH) is cheapest, so a large plane and
+ *  the small objects resting on it end up in separate boxes
+ *  instead of sharing the cells of a fixed grid.
+ *
+ *  Moving an object only refits the boxes above its leaf;
+ *  the tree shape is kept until the next build. Objects
+ *  inserted after a build wait in a short list that queries
+ *  scan directly, and are folded in by a rebuild once that
+ *  list outgrows an eighth of the tree.
+ ***********************************************************/
+class BVH : public SpatialIndex {
+public:
+    BVH();
+
+    // Binned SAH build; the build is serial, so threadCount is ignored
+    void build(const std::vector<SceneObject>& objects, int threadCount = 1) override;
+    void insert(const SceneObject& obj) override;
+    // Swap-and-pops the object out of its leaf and refits the boxes above it
+    void remove(int objectId) override;
+    // Refit only: the leaf and its ancestors are re-bounded, the tree shape is kept
+    bool update(int objectId, const glm::vec3& newPosition, float newRadius) override;
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const override;
+    void queryFrustum(const Frustum& frustum, std::vector<int>& results) const override;
+    bool raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                      float maxDistance = std::numeric_limits<float>::max()) const override;
+    void clear() override;
+    size_t size() const override { return m_objectCount; }
+    bool contains(int objectId) const override { return m_slots.count(objectId) != 0; }
+    const char* name() const override { return "BVH"; }
+
+private:
+    static const uint32_t kInvalidIndex = 0xFFFFFFFFu;
+    static const uint32_t kInternalNode = 0xFFFFFFFFu; // Node::count of a node with children
+    static const uint32_t kPendingSlot = 0x80000000u;  // Slot flag for objects in m_pending
+    static const int kBinCount = 12;
+    static const uint32_t kMaxLeafSize = 8;      // Larger nodes are split even when SAH prefers a leaf
+    static const int kMaxSahDepth = 48;          // Below this depth nodes are split at the median
+    static const size_t kMinPendingRebuild = 32; // Pending objects tolerated before a rebuild
+
+    struct Node {
+        glm::vec3 boundsMin;     // Box around the node's spheres; min > max while empty
+        uint32_t first;          // Leaf: first object in m_objects; internal: left child (right is first + 1)
+        glm::vec3 boundsMax;
+        uint32_t count;          // Objects in a leaf, kInternalNode otherwise
+    };
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;        // Normalized
+        glm::vec3 inverseDirection;
+    };
+
+    std::vector<Node> m_nodes;                  // m_nodes[0] is the root unless empty
+    std::vector<uint32_t> m_parents;            // Parent of each node, for refits
+    std::vector<SceneObject> m_objects;         // Leaf slices in tree order; removals leave gaps at slice ends
+    std::vector<uint32_t> m_leafOf;             // Leaf that owns each m_objects entry
+    std::vector<SceneObject> m_pending;         // Inserted since the last build, not yet in the tree
+    std::unordered_map<int, uint32_t> m_slots;  // id -> m_objects index, or m_pending index | kPendingSlot
+    size_t m_objectCount;
+
+    static bool isLeaf(const Node& node) { return node.count != kInternalNode; }
+    static bool hasBounds(const Node& node) { return node.boundsMin.x <= node.boundsMax.x; }
+    void buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth);
+    // Split point of [first, first + count) by binned SAH, or first + count to make a leaf
+    uint32_t splitObjects(const Node& node, uint32_t first, uint32_t count, int depth);
+    // Recompute a leaf's box from its objects, then its ancestors' until one is unchanged
+    void refit(uint32_t leafIndex);
+    // Build again over the tree's objects and the pending list
+    void rebuild();
+    void removePending(uint32_t index);
+    void queryNode(uint32_t nodeIndex, const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const;
+    void queryFrustumNode(uint32_t nodeIndex, const Frustum& frustum, std::vector<int>& results) const;
+    void collectAll(uint32_t nodeIndex, std::vector<int>& results) const;
+    void raycastNode(uint32_t nodeIndex, const Ray& ray, RayHit& best, bool& found) const;
+};
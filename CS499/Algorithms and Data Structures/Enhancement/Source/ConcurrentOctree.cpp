@@ -0,0 +1,109 @@
+#include "ConcurrentOctree.h"
+#include <atomic>
+
+ConcurrentOctree::ConcurrentOctree(const glm::vec3& center, float halfSize, int maxDepth, float looseness,
+                                   int splitThreshold, int mergeThreshold)
+    : m_published(std::make_shared<Octree>(center, halfSize, maxDepth, looseness, splitThreshold, mergeThreshold)),
+      m_editsReplaceAll(false),
+      m_replayByCopy(false) {
+    m_retired = std::make_shared<Octree>(*m_published);
+}
+
+Octree& ConcurrentOctree::writable(bool keepContents) {
+    if (m_writable)
+        return *m_writable;
+    // use_count cannot rise again once the pointer is no longer published, so 1 means
+    // no reader can still be looking at the retired tree. The fence orders the edits
+    // below after the last reader's release of its reference.
+    if (m_retired && m_retired.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (keepContents) {
+            if (m_replayByCopy || m_replay.size() > m_published->size()) {
+                *m_retired = *m_published;
+            } else {
+                for (const auto& edit : m_replay) apply(*m_retired, edit);
+            }
+        }
+        m_writable = std::move(m_retired);
+    } else {
+        m_writable = std::make_shared<Octree>(*m_published);
+    }
+    m_retired.reset();
+    m_replay.clear();
+    m_replayByCopy = false;
+    return *m_writable;
+}
+
+void ConcurrentOctree::apply(Octree& tree, const Edit& edit) {
+    switch (edit.kind) {
+    case Edit::Insert:
+        tree.insert(edit.object);
+        break;
+    case Edit::Remove:
+        tree.remove(edit.object.id);
+        break;
+    case Edit::Update:
+        tree.update(edit.object.id, edit.object.position, edit.object.boundingRadius);
+        break;
+    }
+}
+
+void ConcurrentOctree::build(const std::vector<SceneObject>& objects, int threadCount) {
+    writable(false).build(objects, threadCount);
+    m_edits.clear();
+    m_editsReplaceAll = true;
+}
+
+void ConcurrentOctree::insert(const SceneObject& obj) {
+    writable().insert(obj);
+    m_edits.push_back(Edit{ Edit::Insert, obj });
+}
+
+void ConcurrentOctree::remove(int objectId) {
+    if (!current().contains(objectId))
+        return;
+    writable().remove(objectId);
+    m_edits.push_back(Edit{ Edit::Remove, SceneObject{ glm::vec3(0.0f), 0.0f, objectId } });
+}
+
+bool ConcurrentOctree::update(int objectId, const glm::vec3& newPosition, float newRadius) {
+    if (!writable().update(objectId, newPosition, newRadius))
+        return false;
+    m_edits.push_back(Edit{ Edit::Update, SceneObject{ newPosition, newRadius, objectId } });
+    return true;
+}
+
+void ConcurrentOctree::clear() {
+    writable(false).clear();
+    m_edits.clear();
+    m_editsReplaceAll = true;
+}
+
+void ConcurrentOctree::query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const {
+    current().query(min, max, results);
+}
+
+void ConcurrentOctree::queryFrustum(const Frustum& frustum, std::vector<int>& results) const {
+    current().queryFrustum(frustum, results);
+}
+
+bool ConcurrentOctree::raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, float maxDistance) const {
+    return current().raycastFirst(origin, direction, hit, maxDistance);
+}
+
+void ConcurrentOctree::publish() {
+    if (!m_writable)
+        return;
+    // contains() would otherwise rebuild the handle map on first use, under the readers
+    m_writable->ensureHandles();
+    m_retired = std::atomic_exchange(&m_published, m_writable);
+    m_writable.reset();
+    m_replay.swap(m_edits);
+    m_edits.clear();
+    m_replayByCopy = m_editsReplaceAll;
+    m_editsReplaceAll = false;
+}
+
+std::shared_ptr<const Octree> ConcurrentOctree::snapshot() const {
+    return std::atomic_load(&m_published);
+}
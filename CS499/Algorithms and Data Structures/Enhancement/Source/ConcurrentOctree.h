@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Octree.h"
+#include "SpatialIndex.h"
+
+/***********************************************************
+ *  ConcurrentOctree
+ *
+ *  Octree that one writer thread edits while any number of
+ *  reader threads query a published snapshot. The writer
+ *  works on a private copy; publish() swaps it in as the
+ *  new snapshot with one atomic pointer store, so readers
+ *  see either the old version or the new one, never a half
+ *  applied edit. A snapshot stays valid for as long as a
+ *  reader holds its shared_ptr.
+ *
+ *  The two copies take turns. Edits made before a publish
+ *  are logged, and once every reader has let go of the
+ *  retired snapshot the writer replays the log onto it
+ *  instead of copying the whole tree. A copy is made only
+ *  when a reader still holds the retired version, when the
+ *  log is longer than the tree, or after a build or clear.
+ *
+ *  Used for culling frame N + 1 on a worker thread while
+ *  the main thread finishes and submits frame N.
+ ***********************************************************/
+class ConcurrentOctree : public SpatialIndex {
+public:
+    ConcurrentOctree(const glm::vec3& center, float halfSize, int maxDepth = 5, float looseness = 2.0f,
+                     int splitThreshold = 8, int mergeThreshold = 4);
+
+    // Writer thread only. Edits and queries go to the writer's copy, so the writer sees
+    // its own changes at once; readers see them after the next publish().
+    void build(const std::vector<SceneObject>& objects, int threadCount = 1) override;
+    void insert(const SceneObject& obj) override;
+    void remove(int objectId) override;
+    bool update(int objectId, const glm::vec3& newPosition, float newRadius) override;
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const override;
+    void queryFrustum(const Frustum& frustum, std::vector<int>& results) const override;
+    bool raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                      float maxDistance = std::numeric_limits<float>::max()) const override;
+    void clear() override;
+    size_t size() const override { return current().size(); }
+    bool contains(int objectId) const override { return current().contains(objectId); }
+    const char* name() const override { return "Octree"; }
+
+    // Writer thread, at a frame boundary: make every edit so far visible to readers.
+    // Does nothing when there has been no edit since the last publish.
+    void publish();
+
+    // Any thread: the latest published tree. Every const query on it is safe to run
+    // concurrently with the writer and with other readers.
+    std::shared_ptr<const Octree> snapshot() const;
+
+private:
+    struct Edit {
+        enum Kind { Insert, Remove, Update };
+        Kind kind;
+        SceneObject object; // Remove only uses the id
+    };
+
+    std::shared_ptr<Octree> m_published; // Readers load it atomically; only publish() replaces it
+    std::shared_ptr<Octree> m_writable;  // Writer's copy; null until the first edit after a publish
+    std::shared_ptr<Octree> m_retired;   // Previous snapshot, reused as the next writable copy
+    std::vector<Edit> m_edits;           // Applied to m_writable since the last publish
+    bool m_editsReplaceAll;              // m_edits follow a build or clear
+    std::vector<Edit> m_replay;          // Edits m_retired is missing
+    bool m_replayByCopy;                 // m_retired missed a build or clear, so it must be copied
+
+    const Octree& current() const { return m_writable ? *m_writable : *m_published; }
+    // A writable copy, brought up to date with the published tree unless the caller is
+    // about to replace its contents anyway
+    Octree& writable(bool keepContents = true);
+    static void apply(Octree& tree, const Edit& edit);
+};
@@ -0,0 +1,152 @@
+#include "FlatSceneGraph.h"
+#include "SceneNode.h"
+#include "ParallelFor.h"
+
+namespace
+{
+    // Below this many entries per thread a level is cheaper to update serially than to
+    // hand to the pool (a wake-up and join per level)
+    const size_t kMinEntriesPerSlice = 1024;
+}
+
+FlatSceneGraph::FlatSceneGraph(std::shared_ptr<SceneNode> root)
+    : m_root(root)
+    , m_parentTransform(1.0f)
+    , m_structureDirty(true)
+    , m_anyDirty(true)
+{
+}
+
+FlatSceneGraph::~FlatSceneGraph()
+{
+    // Walk the live tree rather than m_nodes, which may hold nodes removed since the last rebuild
+    std::vector<SceneNode*> stack;
+    if (m_root) stack.push_back(m_root.get());
+    while (!stack.empty())
+    {
+        SceneNode* node = stack.back();
+        stack.pop_back();
+        if (node->m_flatGraph == this)
+            node->m_flatGraph = nullptr;
+        for (const auto& child : node->getChildren())
+        {
+            stack.push_back(child.get());
+        }
+    }
+}
+
+// Breadth-first layout: the node list doubles as the queue
+void FlatSceneGraph::rebuild()
+{
+    m_nodes.clear();
+    m_parents.clear();
+    m_levelStarts.assign(1, 0);
+    if (m_root)
+    {
+        m_nodes.push_back(m_root.get());
+        m_parents.push_back(-1);
+    }
+    size_t levelEnd = m_nodes.size();
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        SceneNode* node = m_nodes[i];
+        node->m_flatGraph = this;
+        node->m_flatIndex = static_cast<int>(i);
+        for (const auto& child : node->getChildren())
+        {
+            m_nodes.push_back(child.get());
+            m_parents.push_back(static_cast<int>(i));
+        }
+        if (i + 1 == levelEnd)
+        {
+            m_levelStarts.push_back(levelEnd);
+            levelEnd = m_nodes.size();
+        }
+    }
+
+    m_localTransforms.resize(m_nodes.size());
+    m_worldTransforms.resize(m_nodes.size());
+    m_dirty.assign(m_nodes.size(), 1);
+    m_recomputed.resize(m_nodes.size());
+    m_structureDirty = false;
+}
+
+void FlatSceneGraph::update(const glm::mat4& parentTransform, std::vector<const SceneNode*>* changed, int threadCount)
+{
+    if (m_structureDirty)
+        rebuild();
+
+    bool rootMoved = parentTransform != m_parentTransform;
+    // Nothing moved: every world transform is still current, so skip the scan
+    if (!m_anyDirty && !rootMoved)
+        return;
+    m_parentTransform = parentTransform;
+    m_anyDirty = false;
+
+    threadCount = ResolveThreadCount(threadCount);
+    if (threadCount == 1)
+    {
+        for (size_t i = 0; i < m_nodes.size(); ++i)
+        {
+            if (updateEntry(i, parentTransform, rootMoved) && changed)
+                changed->push_back(m_nodes[i]);
+        }
+        return;
+    }
+
+    // A level only reads the one before it, so its slices are independent; joining the
+    // slice lists in order reproduces the serial changed list
+    if (m_sliceChanged.size() < static_cast<size_t>(threadCount))
+        m_sliceChanged.resize(threadCount);
+    for (size_t level = 0; level + 1 < m_levelStarts.size(); ++level)
+    {
+        const size_t first = m_levelStarts[level];
+        const size_t count = m_levelStarts[level + 1] - first;
+        const int slices = static_cast<int>(std::min<size_t>(threadCount, count / kMinEntriesPerSlice + 1));
+        if (slices > 1 && (!m_pool || m_pool->threadCount() != threadCount))
+            m_pool.reset(new WorkerPool(threadCount));
+        auto updateSlice = [&](size_t slice, size_t begin, size_t end) {
+            std::vector<const SceneNode*>& sliceChanged = m_sliceChanged[slice];
+            sliceChanged.clear();
+            for (size_t i = first + begin; i < first + end; ++i)
+            {
+                if (updateEntry(i, parentTransform, rootMoved))
+                    sliceChanged.push_back(m_nodes[i]);
+            }
+        };
+        if (slices > 1)
+            m_pool->forSlices(count, slices, updateSlice);
+        else
+            updateSlice(0, 0, count);
+        if (changed)
+        {
+            for (int slice = 0; slice < slices; ++slice)
+                changed->insert(changed->end(), m_sliceChanged[slice].begin(), m_sliceChanged[slice].end());
+        }
+    }
+}
+
+// Parents precede children, so m_recomputed[parent] is final when a child is reached
+bool FlatSceneGraph::updateEntry(size_t i, const glm::mat4& parentTransform, bool rootMoved)
+{
+    int parent = m_parents[i];
+    bool recompute = m_dirty[i] || (parent < 0 ? rootMoved : m_recomputed[parent] != 0);
+    m_recomputed[i] = recompute ? 1 : 0;
+    if (!recompute)
+        return false;
+
+    SceneNode* node = m_nodes[i];
+    if (m_dirty[i])
+    {
+        m_localTransforms[i] = node->getLocalTransform();
+        m_dirty[i] = 0;
+    }
+    const glm::mat4& parentWorld = parent < 0 ? parentTransform : m_worldTransforms[parent];
+    m_worldTransforms[i] = parentWorld * m_localTransforms[i];
+
+    node->m_worldTransform = m_worldTransforms[i];
+    node->m_parentTransform = parentWorld;
+    node->m_worldDirty = false;
+    node->m_childDirty = false;
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+class SceneNode;
+class WorkerPool;
+
+/***********************************************************
+ *  FlatSceneGraph
+ *
+ *  A SceneNode hierarchy compiled into parallel arrays in
+ *  breadth-first order, so every parent comes before its
+ *  children and world transforms are computed in a single
+ *  linear pass instead of a pointer-chasing recursion.
+ *
+ *  Transform setters on compiled nodes mark their entry
+ *  dirty; addChild/removeChild anywhere in the tree mark the
+ *  layout stale and it is recompiled on the next update().
+ *  Once a tree is compiled, update it through this class.
+ *
+ *  Each depth level is a contiguous range whose entries only
+ *  read the previous level, so update() can split a level
+ *  across threads; the result, including the order of the
+ *  changed list, is the same for any thread count. The
+ *  threads are started once and reused across levels and
+ *  frames.
+ ***********************************************************/
+class FlatSceneGraph
+{
+public:
+    explicit FlatSceneGraph(std::shared_ptr<SceneNode> root);
+    ~FlatSceneGraph();
+
+    FlatSceneGraph(const FlatSceneGraph&) = delete;
+    FlatSceneGraph& operator=(const FlatSceneGraph&) = delete;
+
+    // Recompute world transforms of changed entries and their descendants, writing them back
+    // to the nodes. Recomputed nodes are appended to changed, in array order, when it is given.
+    // Returns at once when no entry is dirty and parentTransform is unchanged.
+    // Levels large enough are split across threadCount threads (0 = all hardware threads).
+    void update(const glm::mat4& parentTransform = glm::mat4(1.0f), std::vector<const SceneNode*>* changed = nullptr,
+        int threadCount = 1);
+
+    // Compiled arrays, valid after update(); parents[i] is -1 for the root
+    size_t size() const { return m_nodes.size(); }
+    size_t levelCount() const { return m_levelStarts.empty() ? 0 : m_levelStarts.size() - 1; }
+    const std::vector<SceneNode*>& getNodes() const { return m_nodes; }
+    const std::vector<int>& getParents() const { return m_parents; }
+    const std::vector<glm::mat4>& getLocalTransforms() const { return m_localTransforms; }
+    const std::vector<glm::mat4>& getWorldTransforms() const { return m_worldTransforms; }
+
+private:
+    friend class SceneNode;
+
+    void markDirty(int index) { m_dirty[index] = 1; m_anyDirty = true; }
+    void markStructureDirty() { m_structureDirty = true; m_anyDirty = true; }
+    void rebuild();
+    bool updateEntry(size_t index, const glm::mat4& parentTransform, bool rootMoved);
+
+    std::shared_ptr<SceneNode> m_root;
+    std::vector<SceneNode*> m_nodes;
+    std::vector<int> m_parents;
+    std::vector<size_t> m_levelStarts; // First entry of each depth level, plus size() at the end
+    std::vector<glm::mat4> m_localTransforms;
+    std::vector<glm::mat4> m_worldTransforms;
+    std::vector<uint8_t> m_dirty;     // Local transform changed since the last update
+    std::vector<uint8_t> m_recomputed; // World transform recomputed in the current update
+    std::vector<std::vector<const SceneNode*> > m_sliceChanged; // Per-thread changed lists
+    std::unique_ptr<WorkerPool> m_pool; // Started the first time a level is split
+    glm::mat4 m_parentTransform;
+    bool m_structureDirty;
+    bool m_anyDirty; // Some entry or the layout changed since the last update
+};
@@ -0,0 +1,109 @@
+#include "Frustum.h"
+#include <algorithm>
+#include <limits>
+
+Frustum::Frustum()
+{
+    for (auto& plane : planes) plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& m)
+{
+    // Gribb/Hartmann extraction; glm is column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[Left] = row3 + row0;
+    frustum.planes[Right] = row3 - row0;
+    frustum.planes[Bottom] = row3 + row1;
+    frustum.planes[Top] = row3 - row1;
+    frustum.planes[Near] = row3 + row2; // OpenGL clip space, z in [-w, w]
+    frustum.planes[Far] = row3 - row2;
+
+    // Normalize so plane distances are in world units (needed for sphere radii)
+    for (auto& plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane /= length;
+    }
+    return frustum;
+}
+
+Frustum Frustum::fromMatrices(const glm::mat4& view, const glm::mat4& projection)
+{
+    return fromMatrix(projection * view);
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const auto& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classifySphere(const glm::vec3& center, float radius) const
+{
+    Containment result = Inside;
+    for (const auto& plane : planes)
+    {
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        if (distance < -radius) return Outside;
+        if (distance < radius) result = Intersecting;
+    }
+    return result;
+}
+
+Frustum::Containment Frustum::classifyBox(const glm::vec3& min, const glm::vec3& max) const
+{
+    Containment result = Inside;
+    for (const auto& plane : planes)
+    {
+        // Corner furthest along the plane normal (p-vertex) and the one opposite (n-vertex)
+        glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+        glm::vec3 negative(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) return Outside;
+        if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f) result = Intersecting;
+    }
+    return result;
+}
+
+Frustum::Containment Frustum::classifyBox(const glm::vec3& min, const glm::vec3& max, float& margin) const
+{
+    // Unlike the overload above this cannot stop at the first rejecting plane, since a
+    // later plane may reject the box by more
+    float nearestInside = std::numeric_limits<float>::max(); // Least n-vertex distance over planes clear of the box
+    float deepestOutside = 0.0f;                             // Largest p-vertex depth behind a plane
+    float nearestFront = std::numeric_limits<float>::max();  // Least p-vertex distance
+    float deepestCut = 0.0f;                                 // Largest n-vertex depth behind a plane
+    for (const auto& plane : planes)
+    {
+        glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+        glm::vec3 negative(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+
+        float positiveDistance = glm::dot(glm::vec3(plane), positive) + plane.w;
+        float negativeDistance = glm::dot(glm::vec3(plane), negative) + plane.w;
+        if (positiveDistance < 0.0f) deepestOutside = std::max(deepestOutside, -positiveDistance);
+        else nearestFront = std::min(nearestFront, positiveDistance);
+        if (negativeDistance < 0.0f) deepestCut = std::max(deepestCut, -negativeDistance);
+        else nearestInside = std::min(nearestInside, negativeDistance);
+    }
+    if (deepestOutside > 0.0f)
+    {
+        margin = deepestOutside;
+        return Outside;
+    }
+    if (deepestCut > 0.0f)
+    {
+        margin = std::min(nearestFront, deepestCut);
+        return Intersecting;
+    }
+    margin = nearestInside;
+    return Inside;
+}
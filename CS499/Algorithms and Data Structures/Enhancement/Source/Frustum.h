@@ -0,0 +1,33 @@
+#pragma once
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  Six clip planes taken from a view-projection matrix.
+ *  Each plane is stored as (normal, d) with the normal
+ *  pointing into the frustum, so dot(n, p) + d >= 0 inside.
+ ***********************************************************/
+struct Frustum
+{
+    enum Containment { Outside, Intersecting, Inside };
+
+    enum PlaneIndex { Left = 0, Right, Bottom, Top, Near, Far, PlaneCount };
+
+    glm::vec4 planes[PlaneCount];
+
+    // Default frustum accepts everything
+    Frustum();
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+    static Frustum fromMatrices(const glm::mat4& view, const glm::mat4& projection);
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    Containment classifySphere(const glm::vec3& center, float radius) const;
+    Containment classifyBox(const glm::vec3& min, const glm::vec3& max) const;
+    // classifyBox that also reports how far the planes would have to move before the
+    // answer could change: the nearest plane distance of an Inside box, the depth of an
+    // Outside box behind the plane that rejects it most, and for an Intersecting box the
+    // smaller of how far it is from falling outside a plane and from clearing all of them
+    Containment classifyBox(const glm::vec3& min, const glm::vec3& max, float& margin) const;
+};
@@ -12,12 +12,16 @@
 //   P/O  - Toggle Perspective/Orthographic view
 //   ESC  - Exit application
 //
+// Command line:
+//   --benchmark - Run the headless spatial index benchmarks and exit
+//
 //  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>         // Standard I/O operations
 #include <cstdlib>          // Exit codes and utilities
+#include <cstring>          // Command line argument comparison
 
 // OpenGL Libraries
 #include <GL/glew.h>        // OpenGL Extension Wrangler Library
@@ -35,6 +39,7 @@
 #include "ShapeMeshes.h"     // 3D shape mesh definitions
 #include "ShaderManager.h"   // GLSL shader program management
 #include "PerformanceProfiler.h" // Performance profiling
+#include "SpatialBenchmark.h"    // Headless spatial index benchmarks
 
 ///////////////////////////////////////////////////////////////////////////////
 // GLOBAL CONSTANTS AND VARIABLES
@@ -70,6 +75,20 @@ bool InitializeGLEW();
  */
 int main(int argc, char* argv[])
 {
+    // Benchmarks run headless, before any window or GL context exists
+    bool useBVH = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--benchmark") == 0)
+        {
+            RunSpatialBenchmarks();
+            return EXIT_SUCCESS;
+        }
+        // Index the static objects with a BVH instead of the default Octree
+        if (std::strcmp(argv[i], "--bvh") == 0)
+            useBVH = true;
+    }
+
     // Initialize GLFW library for window and context management
     if (!InitializeGLFW())
     {
@@ -140,6 +159,8 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    if (useBVH)
+        g_SceneManager->SetStaticIndexKind(SceneManager::StaticIndexKind::BVH);
     g_SceneManager->PrepareScene();
 
     std::cout << "INFO: 3D Scene application initialized successfully" << std::endl;
@@ -166,9 +187,26 @@ int main(int argc, char* argv[])
 
         // Update camera view and projection matrices
         g_ViewManager->PrepareSceneView();
+        g_SceneManager->SetViewProjection(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+        // Cull the static objects on a worker while picking and the scene graph update run here
+        g_SceneManager->BeginCulling();
+
+        // Report the object under the screen center after a left click
+        glm::vec3 pickOrigin, pickDirection;
+        if (g_ViewManager->ConsumePickRay(pickOrigin, pickDirection))
+        {
+            int picked = g_SceneManager->PickObject(pickOrigin, pickDirection);
+            if (picked >= 0)
+                std::cout << "INFO: Picked scene object " << picked << std::endl;
+            else
+                std::cout << "INFO: Nothing under the cursor" << std::endl;
+        }
 
-        // Render all 3D scene objects
+        // Propagate scene graph transforms, then render all 3D scene objects
+        g_SceneManager->UpdateSceneGraph();
         g_SceneManager->RenderScene();
+        // Frame boundary: the next frame's cull sees this frame's index edits
+        g_SceneManager->PublishSceneChanges();
 
         // Swap front and back buffers (double buffering)
         glfwSwapBuffers(g_Window);
@@ -180,6 +218,7 @@ int main(int argc, char* argv[])
         frameCounter++;
         if (frameCounter % 100 == 0)
         {
+            g_SceneManager->RecordSpatialIndexStats();
             profiler.logToConsole();
             profiler.logToFile("performance_log.txt");
         }
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  Read-only memory mapping of a whole file. Pages are only
+ *  read from disk when first touched, so opening a large
+ *  file costs about the same no matter how big it is.
+ ***********************************************************/
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Map path read-only, replacing any current mapping; false if it cannot be mapped
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const unsigned char* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_descriptor;
+#endif
+};
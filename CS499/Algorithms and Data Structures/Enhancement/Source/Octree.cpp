@@ -1,66 +1,1495 @@
 #include "Octree.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
 
-Octree::Octree(const glm::vec3& center, float halfSize, int depth, int maxDepth)
-    : m_center(center), m_halfSize(halfSize), m_depth(depth), m_maxDepth(maxDepth) {}
+const uint32_t Octree::kInvalidIndex;
+const int Octree::kMaxSupportedDepth;
+const int Octree::kMaxRootGrowth;
 
-Octree::~Octree() { clear(); }
+namespace {
+    // Tree revisions are unique across every Octree in the process, so a cull cache
+    // never mistakes one tree for another that happens to share an edit count
+    uint64_t nextRevision() {
+        static std::atomic<uint64_t> counter(0);
+        return ++counter;
+    }
+
+    thread_local OctreeQueryCounters t_queryCounters = {};
+
+    // Spread the low 10 bits of v so they occupy every third bit
+    uint32_t expandBits10(uint32_t v) {
+        v &= 0x3FFu;
+        v = (v | (v << 16)) & 0x030000FFu;
+        v = (v | (v << 8)) & 0x0300F00Fu;
+        v = (v | (v << 4)) & 0x030C30C3u;
+        v = (v | (v << 2)) & 0x09249249u;
+        return v;
+    }
+
+    struct MortonKey {
+        uint32_t code;
+        uint32_t index;
+    };
+
+    // LSD radix sort on a 30-bit code, three 10-bit digits. Each thread counts and
+    // scatters its own slice; per-slice bucket offsets keep the sort stable.
+    template <typename T>
+    void radixSortByCode(std::vector<T>& items, int threadCount) {
+        const int kBits = 10;
+        const uint32_t kBuckets = 1u << kBits;
+        const size_t slices = static_cast<size_t>(std::max(1, std::min<int>(threadCount, static_cast<int>(items.size() / 4096) + 1)));
+        std::vector<T> scratch(items.size());
+        std::vector<size_t> offsets(slices * kBuckets);
+        for (int pass = 0; pass < 3; ++pass) {
+            int shift = pass * kBits;
+            ParallelForSlices(items.size(), static_cast<int>(slices), [&](size_t slice, size_t begin, size_t end) {
+                size_t* counts = &offsets[slice * kBuckets];
+                std::fill(counts, counts + kBuckets, 0);
+                for (size_t i = begin; i < end; ++i) ++counts[(items[i].code >> shift) & (kBuckets - 1)];
+            });
+            size_t total = 0;
+            for (uint32_t bucket = 0; bucket < kBuckets; ++bucket) {
+                for (size_t slice = 0; slice < slices; ++slice) {
+                    size_t& offset = offsets[slice * kBuckets + bucket];
+                    size_t count = offset;
+                    offset = total;
+                    total += count;
+                }
+            }
+            ParallelForSlices(items.size(), static_cast<int>(slices), [&](size_t slice, size_t begin, size_t end) {
+                size_t* next = &offsets[slice * kBuckets];
+                for (size_t i = begin; i < end; ++i) scratch[next[(items[i].code >> shift) & (kBuckets - 1)]++] = items[i];
+            });
+            items.swap(scratch);
+        }
+    }
+
+    // Below this many objects a parallel build costs more in thread start-up than it saves
+    const size_t kMinParallelBuild = 16384;
+
+    // Squared distance from a point to the box [min, max] (0 inside)
+    inline float boxDistanceSq(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 outside = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+        return glm::dot(outside, outside);
+    }
+
+    // Closed boxes overlap when their ranges overlap on every axis
+    inline bool boxesOverlap(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax) {
+        return aMin.x <= bMax.x && bMin.x <= aMax.x && aMin.y <= bMax.y && bMin.y <= aMax.y && aMin.z <= bMax.z && bMin.z <= aMax.z;
+    }
+
+    // Heap order for queryNearest: nearer first, ties broken by id
+    inline bool closerNeighbor(const Neighbor& a, const Neighbor& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    }
+}
+
+void Octree::ObjectStore::copyFrom(const ObjectStore& source, size_t first, size_t count, size_t dest) {
+    std::copy(source.x.begin() + first, source.x.begin() + first + count, x.begin() + dest);
+    std::copy(source.y.begin() + first, source.y.begin() + first + count, y.begin() + dest);
+    std::copy(source.z.begin() + first, source.z.begin() + first + count, z.begin() + dest);
+    std::copy(source.radius.begin() + first, source.radius.begin() + first + count, radius.begin() + dest);
+    std::copy(source.id.begin() + first, source.id.begin() + first + count, id.begin() + dest);
+}
+
+void Octree::ObjectStore::append(const ObjectStore& source, size_t first, size_t count) {
+    size_t dest = size();
+    resize(dest + count);
+    copyFrom(source, first, count, dest);
+}
+
+// A node above the split depth: its own objects and which children the split filled
+struct Octree::BuildSplit {
+    ObjectStore stayers;
+    uint8_t childMask;
+};
+
+// A subtree at the split depth, built into private pools and spliced in afterwards
+struct Octree::BuildTask {
+    Node root;
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    uint32_t nodeIndex = 0;   // Where root lands in m_nodes
+    uint32_t nodeBase = 0;    // Local node i > 0 lands at nodeBase + i
+    uint32_t objectBase = 0;  // Local objects land at objectBase onwards
+    std::vector<Node> nodes;
+    ObjectStore objects;
+};
+
+// Splits and tasks in depth-first order, as the serial build would visit them
+struct Octree::BuildPlan {
+    int splitDepth;
+    std::vector<BuildSplit> splits;
+    std::vector<BuildTask> tasks;
+    size_t nextSplit;
+    size_t nextTask;
+};
+
+Octree::Octree(const glm::vec3& center, float halfSize, int maxDepth, float looseness, int splitThreshold, int mergeThreshold)
+    : m_handlesStale(false),
+      m_objectCount(0),
+      m_wastedObjectSlots(0),
+      m_maxDepth(std::min(std::max(maxDepth, 0), kMaxSupportedDepth)),
+      m_looseness(std::max(looseness, 1.0f)),
+      m_splitThreshold(static_cast<uint32_t>(std::max(splitThreshold, 0))),
+      // A merged node must not be over the split threshold, or it would split straight back
+      m_mergeThreshold(static_cast<uint32_t>(std::min(std::max(mergeThreshold, 0), std::max(splitThreshold, 0)))),
+      m_imageView(),
+      m_revision(nextRevision()) {
+    m_nodes.push_back(makeNode(center, halfSize, kInvalidIndex, 0));
+}
 
 void Octree::clear() {
-    for (auto& child : m_children) child.reset();
+    if (m_image) {
+        Node root = m_imageView.nodes[0];
+        m_image.reset();
+        m_nodes.assign(1, root);
+    }
+    m_nodes.resize(1);
+    m_nodes[0] = makeNode(m_nodes[0].center, m_nodes[0].halfSize, kInvalidIndex, 0);
+    m_freeBlocks.clear();
     m_objects.clear();
+    m_handles.clear();
+    m_handlesStale = false;
+    m_objectCount = 0;
+    m_wastedObjectSlots = 0;
+    m_revision = nextRevision();
+}
+
+bool Octree::contains(int objectId) const {
+    ensureHandles();
+    return m_handles.count(objectId) != 0;
+}
+
+OctreeStats Octree::computeStats() const {
+    const View view = currentView();
+    OctreeStats stats = {};
+    size_t leafObjects = 0;
+    // (node, depth) pairs; depth is counted from the root rather than read from the
+    // node so the histogram does not depend on how the tree was grown
+    std::vector<std::pair<uint32_t, uint32_t> > stack(1, std::make_pair(0u, 0u));
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back().first;
+        const uint32_t depth = stack.back().second;
+        stack.pop_back();
+        const Node& node = view.nodes[nodeIndex];
+        if (stats.nodesPerDepth.size() <= depth) {
+            stats.nodesPerDepth.resize(depth + 1, 0);
+            stats.objectsPerDepth.resize(depth + 1, 0);
+        }
+        ++stats.nodeCount;
+        ++stats.nodesPerDepth[depth];
+        stats.objectsPerDepth[depth] += node.objectCount;
+        stats.objectCount += node.objectCount;
+        if (node.objectCount == 0) ++stats.emptyNodeCount;
+        if (node.childMask == 0) {
+            ++stats.leafCount;
+            leafObjects += node.objectCount;
+            stats.maxObjectsPerLeaf = std::max<size_t>(stats.maxObjectsPerLeaf, node.objectCount);
+            if (node.objectCount == 0) ++stats.emptyLeafCount;
+        }
+        for (int i = 0; i < 8; ++i) {
+            if (node.childMask & (1u << i)) stack.push_back(std::make_pair(node.firstChild + i, depth + 1));
+        }
+    }
+    stats.averageObjectsPerLeaf = stats.leafCount > 0 ? static_cast<double>(leafObjects) / stats.leafCount : 0.0;
+    stats.pooledNodes = view.nodeCount;
+    stats.wastedObjectSlots = m_wastedObjectSlots;
+
+    if (m_image) {
+        stats.bytesUsed = m_image->size();
+    } else {
+        stats.bytesUsed = m_nodes.capacity() * sizeof(Node) +
+            (m_objects.x.capacity() + m_objects.y.capacity() + m_objects.z.capacity() + m_objects.radius.capacity()) * sizeof(float) +
+            m_objects.id.capacity() * sizeof(int);
+    }
+    // Each map entry is a heap node holding the pair and a link, plus one pointer per bucket
+    stats.bytesUsed += m_freeBlocks.capacity() * sizeof(uint32_t) +
+        m_handles.size() * (sizeof(HandleMap::value_type) + sizeof(void*)) + m_handles.bucket_count() * sizeof(void*);
+    return stats;
+}
+
+void Octree::ensureHandles() const {
+    if (!m_handlesStale)
+        return;
+    const View view = currentView();
+    m_handles.clear();
+    m_handles.reserve(m_objectCount);
+    for (uint32_t n = 0; n < view.nodeCount; ++n) {
+        const Node& node = view.nodes[n];
+        for (uint32_t slot = 0; slot < node.objectCount; ++slot)
+            m_handles[view.id[node.firstObject + slot]] = ObjectHandle{ n, slot };
+    }
+    m_handlesStale = false;
+}
+
+const OctreeQueryCounters& Octree::queryCounters() {
+    return t_queryCounters;
+}
+
+Octree::View Octree::currentView() const {
+    if (m_image) {
+        View view = m_imageView;
+        view.counters = &t_queryCounters;
+        return view;
+    }
+    View view;
+    view.nodes = m_nodes.data();
+    view.nodeCount = static_cast<uint32_t>(m_nodes.size());
+    view.objectSlots = static_cast<uint32_t>(m_objects.size());
+    view.x = m_objects.x.data();
+    view.y = m_objects.y.data();
+    view.z = m_objects.z.data();
+    view.radius = m_objects.radius.data();
+    view.id = m_objects.id.data();
+    view.counters = &t_queryCounters;
+    return view;
+}
+
+namespace {
+    const char kImageMagic[8] = { 'O', 'C', 'T', 'R', 'E', 'E', 'I', 'M' };
+    const uint32_t kImageVersion = 1;
+    const uint32_t kImageByteOrder = 0x01020304u; // Reads back differently on a machine of the other endianness
+    const uint64_t kImageAlignment = 64;          // Every section starts on a cache line
+
+    // Fixed-size file header; sections are located by byte offset from the start of the file
+    struct ImageHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t nodeSize;
+        uint32_t nodeCount;
+        uint32_t freeBlockCount;
+        uint32_t objectCount;
+        int32_t maxDepth;
+        float looseness;
+        uint32_t splitThreshold;
+        uint32_t mergeThreshold;
+        uint64_t nodesOffset;
+        uint64_t freeBlocksOffset;
+        uint64_t xOffset, yOffset, zOffset, radiusOffset, idOffset;
+        uint64_t fileSize;
+    };
+
+    uint64_t alignImageOffset(uint64_t offset) {
+        return (offset + kImageAlignment - 1) & ~(kImageAlignment - 1);
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize) {
+        return offset % kImageAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+}
+
+bool Octree::save(const std::string& path) const {
+    // Pack the slices in node order so the image carries no abandoned capacity
+    const View view = currentView();
+    std::vector<Node> nodes(view.nodes, view.nodes + view.nodeCount);
+    ObjectStore objects;
+    objects.reserve(m_objectCount);
+    const size_t nodeBytesUsed = offsetof(Node, depth) + sizeof(uint8_t);
+    for (auto& node : nodes) {
+        // Copies need not keep the padding makeNode zeroed, so clear it again before writing
+        std::memset(reinterpret_cast<char*>(&node) + nodeBytesUsed, 0, sizeof(Node) - nodeBytesUsed);
+        const uint32_t first = node.firstObject;
+        const uint32_t last = first + node.objectCount;
+        node.firstObject = static_cast<uint32_t>(objects.size());
+        node.objectCapacity = node.objectCount;
+        objects.x.insert(objects.x.end(), view.x + first, view.x + last);
+        objects.y.insert(objects.y.end(), view.y + first, view.y + last);
+        objects.z.insert(objects.z.end(), view.z + first, view.z + last);
+        objects.radius.insert(objects.radius.end(), view.radius + first, view.radius + last);
+        objects.id.insert(objects.id.end(), view.id + first, view.id + last);
+    }
+
+    ImageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kImageMagic, sizeof(kImageMagic));
+    header.version = kImageVersion;
+    header.byteOrder = kImageByteOrder;
+    header.nodeSize = sizeof(Node);
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.freeBlockCount = static_cast<uint32_t>(m_freeBlocks.size());
+    header.objectCount = static_cast<uint32_t>(objects.size());
+    header.maxDepth = m_maxDepth;
+    header.looseness = m_looseness;
+    header.splitThreshold = m_splitThreshold;
+    header.mergeThreshold = m_mergeThreshold;
+
+    const uint64_t floatBytes = objects.size() * sizeof(float);
+    uint64_t offset = alignImageOffset(sizeof(ImageHeader));
+    header.nodesOffset = offset;      offset = alignImageOffset(offset + nodes.size() * sizeof(Node));
+    header.freeBlocksOffset = offset; offset = alignImageOffset(offset + m_freeBlocks.size() * sizeof(uint32_t));
+    header.xOffset = offset;          offset = alignImageOffset(offset + floatBytes);
+    header.yOffset = offset;          offset = alignImageOffset(offset + floatBytes);
+    header.zOffset = offset;          offset = alignImageOffset(offset + floatBytes);
+    header.radiusOffset = offset;     offset = alignImageOffset(offset + floatBytes);
+    header.idOffset = offset;         offset = alignImageOffset(offset + objects.size() * sizeof(int));
+    header.fileSize = offset;
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    uint64_t written = 0;
+    auto writeSection = [&](uint64_t sectionOffset, const void* data, uint64_t bytes) {
+        static const char padding[kImageAlignment] = {};
+        out.write(padding, static_cast<std::streamsize>(sectionOffset - written));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written = sectionOffset + bytes;
+    };
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.nodesOffset, nodes.data(), nodes.size() * sizeof(Node));
+    writeSection(header.freeBlocksOffset, m_freeBlocks.data(), m_freeBlocks.size() * sizeof(uint32_t));
+    writeSection(header.xOffset, objects.x.data(), floatBytes);
+    writeSection(header.yOffset, objects.y.data(), floatBytes);
+    writeSection(header.zOffset, objects.z.data(), floatBytes);
+    writeSection(header.radiusOffset, objects.radius.data(), floatBytes);
+    writeSection(header.idOffset, objects.id.data(), objects.size() * sizeof(int));
+    writeSection(header.fileSize, nullptr, 0);
+    return static_cast<bool>(out.flush());
+}
+
+bool Octree::load(const std::string& path) {
+    std::shared_ptr<MappedFile> image = std::make_shared<MappedFile>();
+    if (!image->open(path) || image->size() < sizeof(ImageHeader))
+        return false;
+    ImageHeader header;
+    std::memcpy(&header, image->data(), sizeof(header));
+    // Only the layout is checked; node contents are trusted as written by save()
+    if (std::memcmp(header.magic, kImageMagic, sizeof(kImageMagic)) != 0 || header.version != kImageVersion ||
+        header.byteOrder != kImageByteOrder || header.nodeSize != sizeof(Node) || header.nodeCount == 0 ||
+        header.maxDepth < 0 || header.maxDepth > kMaxSupportedDepth || header.fileSize != image->size())
+        return false;
+    const uint64_t fileSize = header.fileSize;
+    if (!sectionFits(header.nodesOffset, header.nodeCount, sizeof(Node), fileSize) ||
+        !sectionFits(header.freeBlocksOffset, header.freeBlockCount, sizeof(uint32_t), fileSize) ||
+        !sectionFits(header.xOffset, header.objectCount, sizeof(float), fileSize) ||
+        !sectionFits(header.yOffset, header.objectCount, sizeof(float), fileSize) ||
+        !sectionFits(header.zOffset, header.objectCount, sizeof(float), fileSize) ||
+        !sectionFits(header.radiusOffset, header.objectCount, sizeof(float), fileSize) ||
+        !sectionFits(header.idOffset, header.objectCount, sizeof(int), fileSize))
+        return false;
+
+    const unsigned char* base = image->data();
+    View view;
+    view.nodes = reinterpret_cast<const Node*>(base + header.nodesOffset);
+    view.nodeCount = header.nodeCount;
+    view.objectSlots = header.objectCount;
+    view.x = reinterpret_cast<const float*>(base + header.xOffset);
+    view.y = reinterpret_cast<const float*>(base + header.yOffset);
+    view.z = reinterpret_cast<const float*>(base + header.zOffset);
+    view.radius = reinterpret_cast<const float*>(base + header.radiusOffset);
+    view.id = reinterpret_cast<const int*>(base + header.idOffset);
+    view.counters = nullptr;
+    const uint32_t* freeBlocks = reinterpret_cast<const uint32_t*>(base + header.freeBlocksOffset);
+
+    // The image replaces the in-memory pools outright
+    std::vector<Node>().swap(m_nodes);
+    ObjectStore().swap(m_objects);
+    m_freeBlocks.assign(freeBlocks, freeBlocks + header.freeBlockCount);
+    m_handles.clear();
+    m_handlesStale = true;
+    m_objectCount = header.objectCount;
+    m_wastedObjectSlots = 0;
+    m_maxDepth = header.maxDepth;
+    m_looseness = header.looseness;
+    m_splitThreshold = header.splitThreshold;
+    m_mergeThreshold = header.mergeThreshold;
+    m_image = image;
+    m_imageView = view;
+    m_revision = nextRevision();
+    return true;
 }
 
-bool Octree::isLeaf() const { return m_depth >= m_maxDepth; }
+void Octree::releaseImage() {
+    if (!m_image)
+        return;
+    // The image is already packed, so node slices and handles carry over unchanged
+    const View& view = m_imageView;
+    m_nodes.assign(view.nodes, view.nodes + view.nodeCount);
+    m_objects.x.assign(view.x, view.x + m_objectCount);
+    m_objects.y.assign(view.y, view.y + m_objectCount);
+    m_objects.z.assign(view.z, view.z + m_objectCount);
+    m_objects.radius.assign(view.radius, view.radius + m_objectCount);
+    m_objects.id.assign(view.id, view.id + m_objectCount);
+    m_image.reset();
+}
 
-int Octree::getChildIndex(const glm::vec3& pos) const {
+uint32_t Octree::mortonCode(const glm::vec3& pos) const {
+    const Node& root = m_nodes[0];
+    const float cells = static_cast<float>(1 << kMaxSupportedDepth);
+    glm::vec3 cell = glm::floor((pos - (root.center - glm::vec3(root.halfSize))) * (cells / (2.0f * root.halfSize)));
+    glm::vec3 clamped = glm::clamp(cell, glm::vec3(0.0f), glm::vec3(cells - 1.0f));
+    // x in bit 0, y in bit 1, z in bit 2 of every triple, matching getChildIndex
+    return expandBits10(static_cast<uint32_t>(clamped.x))
+        | (expandBits10(static_cast<uint32_t>(clamped.y)) << 1)
+        | (expandBits10(static_cast<uint32_t>(clamped.z)) << 2);
+}
+
+void Octree::build(const std::vector<SceneObject>& objects, int threadCount) {
+    clear();
+    if (objects.empty())
+        return;
+    threadCount = ResolveThreadCount(threadCount);
+    // Still empty, so growing only resizes the root
+    for (const auto& obj : objects) growToFit(obj);
+
+    // Sort small (code, index) keys, then gather the objects once in Morton order
+    std::vector<MortonKey> keys(objects.size());
+    ParallelForSlices(objects.size(), threadCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            keys[i].code = mortonCode(objects[i].position);
+            keys[i].index = static_cast<uint32_t>(i);
+        }
+    });
+    radixSortByCode(keys, threadCount);
+
+    std::vector<BuildEntry> entries(objects.size());
+    ParallelForSlices(keys.size(), threadCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            entries[i].code = keys[i].code;
+            entries[i].object = objects[keys[i].index];
+        }
+    });
+
+    if (threadCount > 1 && m_maxDepth > 0 && entries.size() >= kMinParallelBuild) {
+        buildParallel(entries, threadCount);
+    } else {
+        m_objects.reserve(objects.size());
+        buildNode(m_nodes, m_objects, 0, 0, static_cast<uint32_t>(entries.size()), entries);
+    }
+    m_objectCount = objects.size();
+    m_handlesStale = true;
+}
+
+void Octree::includeObjects(Node& node, const ObjectStore& objects, uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+        glm::vec3 position(objects.x[i], objects.y[i], objects.z[i]);
+        node.boundsMin = glm::min(node.boundsMin, position - glm::vec3(objects.radius[i]));
+        node.boundsMax = glm::max(node.boundsMax, position + glm::vec3(objects.radius[i]));
+    }
+}
+
+void Octree::includeChildren(std::vector<Node>& nodes, uint32_t nodeIndex) {
+    Node& node = nodes[nodeIndex];
+    node.subtreeCount = node.objectCount;
+    for (int c = 0; c < 8; ++c) {
+        if (node.childMask & (1u << c)) {
+            const Node& child = nodes[node.firstChild + c];
+            node.boundsMin = glm::min(node.boundsMin, child.boundsMin);
+            node.boundsMax = glm::max(node.boundsMax, child.boundsMax);
+            node.subtreeCount += child.subtreeCount;
+        }
+    }
+}
+
+void Octree::includeInAncestors(uint32_t nodeIndex, const SceneObject& obj) {
+    glm::vec3 sphereMin = obj.position - glm::vec3(obj.boundingRadius);
+    glm::vec3 sphereMax = obj.position + glm::vec3(obj.boundingRadius);
+    // Each box holds its children's, so once one node already covers the sphere all its ancestors do
+    for (uint32_t n = nodeIndex; n != kInvalidIndex; n = m_nodes[n].parent) {
+        Node& node = m_nodes[n];
+        if (glm::all(glm::lessThanEqual(node.boundsMin, sphereMin)) && glm::all(glm::greaterThanEqual(node.boundsMax, sphereMax)))
+            break;
+        node.boundsMin = glm::min(node.boundsMin, sphereMin);
+        node.boundsMax = glm::max(node.boundsMax, sphereMax);
+    }
+}
+
+void Octree::addToSubtreeCounts(uint32_t nodeIndex, int delta) {
+    for (uint32_t n = nodeIndex; n != kInvalidIndex; n = m_nodes[n].parent)
+        m_nodes[n].subtreeCount += delta;
+}
+
+uint32_t Octree::splitEntries(const Node& node, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries, ObjectStore& stayers) const {
+    if (atMaxDepth(node) || end - begin <= m_splitThreshold) {
+        for (uint32_t i = begin; i < end; ++i) stayers.push_back(entries[i].object);
+        return begin;
+    }
+    // Objects that fit the child picked by their code move to the front of the
+    // range (keeping Morton order); the rest stay at this node.
+    const int shift = 3 * (kMaxSupportedDepth - 1 - node.depth); // Child bits for this depth
+    const float childExtent = node.halfSize * 0.5f * m_looseness;
+    glm::vec3 childCenters[8];
+    for (int c = 0; c < 8; ++c) childCenters[c] = getChildCenter(node, c);
+    uint32_t write = begin;
+    for (uint32_t i = begin; i < end; ++i) {
+        const SceneObject& obj = entries[i].object;
+        glm::vec3 d = glm::abs(obj.position - childCenters[(entries[i].code >> shift) & 7]);
+        if (std::max(d.x, std::max(d.y, d.z)) + obj.boundingRadius <= childExtent) {
+            if (write != i) entries[write] = entries[i];
+            ++write;
+        } else {
+            stayers.push_back(obj);
+        }
+    }
+    return write;
+}
+
+void Octree::buildNode(std::vector<Node>& nodes, ObjectStore& objects, uint32_t nodeIndex, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries) const {
+    const int depth = nodes[nodeIndex].depth;
+    const int shift = 3 * (kMaxSupportedDepth - 1 - depth);
+    uint32_t firstObject = static_cast<uint32_t>(objects.size());
+    uint32_t write = splitEntries(nodes[nodeIndex], begin, end, entries, objects);
+
+    Node& stored = nodes[nodeIndex];
+    stored.firstObject = firstObject;
+    stored.objectCount = stored.objectCapacity = static_cast<uint32_t>(objects.size()) - firstObject;
+    includeObjects(stored, objects, firstObject, stored.objectCount);
+    stored.subtreeCount = stored.objectCount;
+    if (write == begin)
+        return;
+
+    // Children's ranges are contiguous runs of equal child bits
+    uint32_t firstChild = allocateChildren(nodes, nodeIndex);
+    for (uint32_t runBegin = begin; runBegin < write;) {
+        uint32_t child = (entries[runBegin].code >> shift) & 7;
+        uint32_t runEnd = runBegin + 1;
+        while (runEnd < write && ((entries[runEnd].code >> shift) & 7) == child) ++runEnd;
+        nodes[nodeIndex].childMask |= static_cast<uint8_t>(1u << child);
+        buildNode(nodes, objects, firstChild + child, runBegin, runEnd, entries);
+        runBegin = runEnd;
+    }
+    includeChildren(nodes, nodeIndex);
+}
+
+void Octree::buildParallel(std::vector<BuildEntry>& entries, int threadCount) {
+    // Split the top levels serially; one level gives up to 8 subtrees, two give up
+    // to 64 (one per 6-bit Morton prefix) so more threads stay balanced.
+    BuildPlan plan;
+    plan.splitDepth = (threadCount > 8 && m_maxDepth >= 2) ? 2 : 1;
+    plan.nextSplit = 0;
+    plan.nextTask = 0;
+    planSplit(m_nodes[0], 0, static_cast<uint32_t>(entries.size()), entries, plan);
+
+    // Subtree ranges are disjoint, so tasks can compact their entries concurrently
+    ParallelForEach(plan.tasks.size(), threadCount, [&](size_t t) {
+        BuildTask& task = plan.tasks[t];
+        task.objects.reserve(task.end - task.begin);
+        task.nodes.push_back(task.root);
+        buildNode(task.nodes, task.objects, 0, task.begin, task.end, entries);
+    });
+
+    // Lay out the top levels exactly as buildNode would, reserving each subtree's
+    // range at the point the serial build would have reached it
+    m_objects.reserve(entries.size());
+    emitSplit(0, plan);
+
+    // Relocate local indices into the reserved ranges
+    ParallelForEach(plan.tasks.size(), threadCount, [&](size_t t) {
+        const BuildTask& task = plan.tasks[t];
+        for (size_t i = 0; i < task.nodes.size(); ++i) {
+            Node node = task.nodes[i];
+            if (node.firstChild != kInvalidIndex) node.firstChild += task.nodeBase;
+            // Children the split never used keep their zero offset, as in the serial build
+            bool used = i == 0 || (task.nodes[node.parent].childMask & (1u << (i - task.nodes[node.parent].firstChild))) != 0;
+            if (used) node.firstObject += task.objectBase;
+            if (i == 0) {
+                node.parent = m_nodes[task.nodeIndex].parent;
+                m_nodes[task.nodeIndex] = node;
+            } else {
+                node.parent = node.parent == 0 ? task.nodeIndex : node.parent + task.nodeBase;
+                m_nodes[task.nodeBase + i] = node;
+            }
+        }
+        m_objects.copyFrom(task.objects, 0, task.objects.size(), task.objectBase);
+    });
+    finishSplitNodes(0, plan.splitDepth);
+}
+
+void Octree::finishSplitNodes(uint32_t nodeIndex, int splitDepth) {
+    // Subtree boxes and counts are only known once the tasks are spliced in
+    if (m_nodes[nodeIndex].depth >= splitDepth)
+        return;
+    for (int c = 0; c < 8; ++c) {
+        if (m_nodes[nodeIndex].childMask & (1u << c)) finishSplitNodes(m_nodes[nodeIndex].firstChild + c, splitDepth);
+    }
+    includeChildren(m_nodes, nodeIndex);
+}
+
+void Octree::planSplit(const Node& node, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries, BuildPlan& plan) const {
+    if (node.depth == plan.splitDepth) {
+        BuildTask task;
+        task.root = node;
+        task.begin = begin;
+        task.end = end;
+        plan.tasks.push_back(std::move(task));
+        return;
+    }
+
+    size_t splitIndex = plan.splits.size();
+    plan.splits.push_back(BuildSplit());
+    plan.splits[splitIndex].childMask = 0;
+    uint32_t write = splitEntries(node, begin, end, entries, plan.splits[splitIndex].stayers);
+
+    const int shift = 3 * (kMaxSupportedDepth - 1 - node.depth);
+    for (uint32_t runBegin = begin; runBegin < write;) {
+        uint32_t child = (entries[runBegin].code >> shift) & 7;
+        uint32_t runEnd = runBegin + 1;
+        while (runEnd < write && ((entries[runEnd].code >> shift) & 7) == child) ++runEnd;
+        plan.splits[splitIndex].childMask |= static_cast<uint8_t>(1u << child);
+        planSplit(makeNode(getChildCenter(node, child), node.halfSize * 0.5f, kInvalidIndex, node.depth + 1), runBegin, runEnd, entries, plan);
+        runBegin = runEnd;
+    }
+}
+
+void Octree::emitSplit(uint32_t nodeIndex, BuildPlan& plan) {
+    if (m_nodes[nodeIndex].depth == plan.splitDepth) {
+        BuildTask& task = plan.tasks[plan.nextTask++];
+        task.nodeIndex = nodeIndex;
+        task.nodeBase = static_cast<uint32_t>(m_nodes.size()) - 1;
+        task.objectBase = static_cast<uint32_t>(m_objects.size());
+        m_nodes.resize(m_nodes.size() + task.nodes.size() - 1);
+        m_objects.resize(m_objects.size() + task.objects.size());
+        return;
+    }
+
+    const BuildSplit& split = plan.splits[plan.nextSplit++];
+    Node& node = m_nodes[nodeIndex];
+    node.firstObject = static_cast<uint32_t>(m_objects.size());
+    node.objectCount = node.objectCapacity = static_cast<uint32_t>(split.stayers.size());
+    m_objects.append(split.stayers, 0, split.stayers.size());
+    includeObjects(node, split.stayers, 0, node.objectCount);
+    node.subtreeCount = node.objectCount;
+    if (split.childMask == 0)
+        return;
+
+    uint32_t firstChild = allocateChildren(m_nodes, nodeIndex);
+    m_nodes[nodeIndex].childMask = split.childMask;
+    for (int c = 0; c < 8; ++c) {
+        if (split.childMask & (1u << c)) emitSplit(firstChild + c, plan);
+    }
+}
+
+Octree::Node Octree::makeNode(const glm::vec3& center, float halfSize, uint32_t parent, int depth) const {
+    Node node;
+    std::memset(&node, 0, sizeof(node)); // Padding included, so saved images are reproducible
+    node.center = center;
+    node.halfSize = halfSize;
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    node.parent = parent;
+    node.firstChild = kInvalidIndex;
+    node.firstObject = 0;
+    node.objectCount = 0;
+    node.objectCapacity = 0;
+    node.subtreeCount = 0;
+    node.childMask = 0;
+    node.depth = static_cast<uint8_t>(depth);
+    return node;
+}
+
+int Octree::getChildIndex(const Node& node, const glm::vec3& pos) {
     int idx = 0;
-    if (pos.x > m_center.x) idx |= 1;
-    if (pos.y > m_center.y) idx |= 2;
-    if (pos.z > m_center.z) idx |= 4;
+    if (pos.x > node.center.x) idx |= 1;
+    if (pos.y > node.center.y) idx |= 2;
+    if (pos.z > node.center.z) idx |= 4;
     return idx;
 }
 
+glm::vec3 Octree::getChildCenter(const Node& node, int idx) {
+    glm::vec3 offset(
+        (idx & 1 ? 0.5f : -0.5f) * node.halfSize,
+        (idx & 2 ? 0.5f : -0.5f) * node.halfSize,
+        (idx & 4 ? 0.5f : -0.5f) * node.halfSize
+    );
+    return node.center + offset;
+}
+
+int Octree::findChildFor(const Node& node, const SceneObject& obj) const {
+    if (atMaxDepth(node))
+        return -1;
+    int idx = getChildIndex(node, obj.position);
+    glm::vec3 d = glm::abs(obj.position - getChildCenter(node, idx));
+    float childExtent = node.halfSize * 0.5f * m_looseness;
+    if (std::max(d.x, std::max(d.y, d.z)) + obj.boundingRadius > childExtent)
+        return -1;
+    return idx;
+}
+
+bool Octree::canHold(const Node& node, const SceneObject& obj) const {
+    glm::vec3 d = glm::abs(obj.position - node.center);
+    float dMax = std::max(d.x, std::max(d.y, d.z));
+    return dMax <= node.halfSize && dMax + obj.boundingRadius <= node.halfSize * m_looseness;
+}
+
+uint32_t Octree::allocateChildren(std::vector<Node>& nodes, uint32_t nodeIndex) const {
+    // All eight children are laid out together so child i is firstChild + i
+    uint32_t first = static_cast<uint32_t>(nodes.size());
+    Node parent = nodes[nodeIndex];
+    for (int i = 0; i < 8; ++i) {
+        nodes.push_back(makeNode(getChildCenter(parent, i), parent.halfSize * 0.5f, nodeIndex, parent.depth + 1));
+    }
+    nodes[nodeIndex].firstChild = first;
+    return first;
+}
+
+uint32_t Octree::acquireChildBlock(uint32_t nodeIndex) {
+    if (m_freeBlocks.empty())
+        return allocateChildren(m_nodes, nodeIndex);
+    uint32_t first = m_freeBlocks.back();
+    m_freeBlocks.pop_back();
+    Node parent = m_nodes[nodeIndex];
+    for (int i = 0; i < 8; ++i) {
+        m_nodes[first + i] = makeNode(getChildCenter(parent, i), parent.halfSize * 0.5f, nodeIndex, parent.depth + 1);
+    }
+    m_nodes[nodeIndex].firstChild = first;
+    return first;
+}
+
 void Octree::insert(const SceneObject& obj) {
-    if (isLeaf()) {
-        m_objects.push_back(obj);
+    releaseImage();
+    m_revision = nextRevision();
+    ensureHandles();
+    auto it = m_handles.find(obj.id);
+    if (it != m_handles.end()) {
+        uint32_t oldNode = it->second.node;
+        detach(it);
+        mergeUpwards(oldNode);
+    }
+    growToFit(obj);
+    place(0, obj);
+}
+
+void Octree::growToFit(const SceneObject& obj) {
+    if (!std::isfinite(obj.position.x) || !std::isfinite(obj.position.y) || !std::isfinite(obj.position.z) ||
+        !std::isfinite(obj.boundingRadius))
+        return;
+    for (int grow = 0; grow < kMaxRootGrowth && !canHold(m_nodes[0], obj); ++grow)
+        growRoot(obj.position);
+}
+
+void Octree::growRoot(const glm::vec3& toward) {
+    Node oldRoot = m_nodes[0];
+    glm::vec3 step(
+        toward.x > oldRoot.center.x ? oldRoot.halfSize : -oldRoot.halfSize,
+        toward.y > oldRoot.center.y ? oldRoot.halfSize : -oldRoot.halfSize,
+        toward.z > oldRoot.center.z ? oldRoot.halfSize : -oldRoot.halfSize
+    );
+    glm::vec3 newCenter = oldRoot.center + step;
+
+    if (m_maxDepth >= kMaxSupportedDepth) {
+        // Another level would overflow the Morton codes, so lay the tree out again
+        // under the bigger root with coarser leaves
+        std::vector<SceneObject> objects;
+        objects.reserve(m_objectCount);
+        for (const auto& node : m_nodes) {
+            for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+                objects.push_back(m_objects.get(i));
+        }
+        m_nodes[0].center = newCenter;
+        m_nodes[0].halfSize = oldRoot.halfSize * 2.0f;
+        build(objects);
+        ensureHandles();
         return;
     }
-    int idx = getChildIndex(obj.position);
-    if (!m_children[idx]) {
-        glm::vec3 offset(
-            (idx & 1 ? 0.5f : -0.5f) * m_halfSize,
-            (idx & 2 ? 0.5f : -0.5f) * m_halfSize,
-            (idx & 4 ? 0.5f : -0.5f) * m_halfSize
-        );
-        m_children[idx] = std::make_unique<Octree>(m_center + offset, m_halfSize * 0.5f, m_depth + 1, m_maxDepth);
+
+    // Every existing node moves one level down
+    ++m_maxDepth;
+    for (auto& node : m_nodes) ++node.depth;
+    m_nodes[0] = makeNode(newCenter, oldRoot.halfSize * 2.0f, kInvalidIndex, 0);
+    int octant = getChildIndex(m_nodes[0], oldRoot.center);
+    uint32_t moved = acquireChildBlock(0) + octant;
+
+    m_nodes[moved] = oldRoot;
+    m_nodes[moved].parent = 0;
+    m_nodes[moved].depth = 1;
+    if (isSplit(oldRoot)) {
+        for (int c = 0; c < 8; ++c) m_nodes[oldRoot.firstChild + c].parent = moved;
+    }
+    if (!m_handlesStale) {
+        for (uint32_t slot = 0; slot < oldRoot.objectCount; ++slot)
+            m_handles[m_objects.id[oldRoot.firstObject + slot]].node = moved;
     }
-    m_children[idx]->insert(obj);
+
+    Node& root = m_nodes[0];
+    root.childMask = static_cast<uint8_t>(1u << octant);
+    root.boundsMin = oldRoot.boundsMin;
+    root.boundsMax = oldRoot.boundsMax;
+    root.subtreeCount = oldRoot.subtreeCount;
+}
+
+void Octree::place(uint32_t start, const SceneObject& obj) {
+    // Descend through nodes that are already split; only the node that ends up
+    // over the threshold is subdivided
+    uint32_t nodeIndex = start;
+    for (int idx = descendChild(m_nodes[nodeIndex], obj); idx >= 0; idx = descendChild(m_nodes[nodeIndex], obj)) {
+        m_nodes[nodeIndex].childMask |= static_cast<uint8_t>(1u << idx);
+        nodeIndex = m_nodes[nodeIndex].firstChild + idx;
+    }
+    uint32_t slot = appendToNode(nodeIndex, obj);
+    includeInAncestors(nodeIndex, obj);
+    addToSubtreeCounts(nodeIndex, 1);
+    m_handles[obj.id] = ObjectHandle{ nodeIndex, slot };
+    ++m_objectCount;
+
+    const Node& node = m_nodes[nodeIndex];
+    if (!isSplit(node) && !atMaxDepth(node) && node.objectCount > m_splitThreshold)
+        splitNode(nodeIndex);
+}
+
+void Octree::splitNode(uint32_t nodeIndex) {
+    acquireChildBlock(nodeIndex);
+    // Walk the slice backwards so the object swapped into a freed slot was already visited
+    for (uint32_t slot = m_nodes[nodeIndex].objectCount; slot-- > 0;) {
+        SceneObject obj = m_objects.get(m_nodes[nodeIndex].firstObject + slot);
+        int idx = findChildFor(m_nodes[nodeIndex], obj);
+        if (idx < 0)
+            continue;
+        removeSlot(nodeIndex, slot);
+        m_nodes[nodeIndex].childMask |= static_cast<uint8_t>(1u << idx);
+        uint32_t child = m_nodes[nodeIndex].firstChild + idx;
+        uint32_t childSlot = appendToNode(child, obj);
+        includeObjects(m_nodes[child], m_objects, m_nodes[child].firstObject + childSlot, 1);
+        ++m_nodes[child].subtreeCount;
+        m_handles[obj.id] = ObjectHandle{ child, childSlot };
+    }
+    for (int c = 0; c < 8; ++c) {
+        uint32_t child = m_nodes[nodeIndex].firstChild + c;
+        if (!atMaxDepth(m_nodes[child]) && m_nodes[child].objectCount > m_splitThreshold)
+            splitNode(child);
+    }
+}
+
+void Octree::mergeUpwards(uint32_t nodeIndex) {
+    uint32_t highest = kInvalidIndex;
+    for (uint32_t n = nodeIndex; n != kInvalidIndex; n = m_nodes[n].parent) {
+        if (isSplit(m_nodes[n]) && m_nodes[n].subtreeCount <= m_mergeThreshold)
+            highest = n;
+    }
+    if (highest != kInvalidIndex)
+        collapseNode(highest);
+}
+
+void Octree::collapseNode(uint32_t nodeIndex) {
+    for (int c = 0; c < 8; ++c) {
+        if (m_nodes[nodeIndex].childMask & (1u << c)) pullUpObjects(nodeIndex, m_nodes[nodeIndex].firstChild + c);
+    }
+    m_freeBlocks.push_back(m_nodes[nodeIndex].firstChild);
+    Node& node = m_nodes[nodeIndex];
+    node.firstChild = kInvalidIndex;
+    node.childMask = 0;
+    // Everything is local again, so the box can shrink back to the objects it holds
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    includeObjects(node, m_objects, node.firstObject, node.objectCount);
+}
+
+void Octree::pullUpObjects(uint32_t target, uint32_t nodeIndex) {
+    for (int c = 0; c < 8; ++c) {
+        if (m_nodes[nodeIndex].childMask & (1u << c)) pullUpObjects(target, m_nodes[nodeIndex].firstChild + c);
+    }
+    if (isSplit(m_nodes[nodeIndex]))
+        m_freeBlocks.push_back(m_nodes[nodeIndex].firstChild);
+    // appendToNode may compact the object array, so slice offsets are re-read every step
+    for (uint32_t slot = 0; slot < m_nodes[nodeIndex].objectCount; ++slot) {
+        SceneObject obj = m_objects.get(m_nodes[nodeIndex].firstObject + slot);
+        m_handles[obj.id] = ObjectHandle{ target, appendToNode(target, obj) };
+    }
+    Node& node = m_nodes[nodeIndex];
+    m_wastedObjectSlots += node.objectCapacity;
+    node.objectCount = node.objectCapacity = node.subtreeCount = 0;
+    node.firstChild = kInvalidIndex;
+    node.childMask = 0;
+}
+
+uint32_t Octree::appendToNode(uint32_t nodeIndex, const SceneObject& obj) {
+    Node& node = m_nodes[nodeIndex];
+    if (node.objectCount == node.objectCapacity) {
+        uint32_t newCapacity = std::max<uint32_t>(4, node.objectCapacity * 2);
+        if (node.firstObject + node.objectCapacity == m_objects.size()) {
+            // Slice already sits at the end of the array, so grow it in place
+            m_objects.resize(node.firstObject + newCapacity);
+        } else {
+            // Move the slice to the end; handles are slice-relative so they stay valid
+            uint32_t newFirst = static_cast<uint32_t>(m_objects.size());
+            m_objects.resize(newFirst + newCapacity);
+            m_objects.copyFrom(m_objects, node.firstObject, node.objectCount, newFirst);
+            m_wastedObjectSlots += node.objectCapacity;
+            node.firstObject = newFirst;
+        }
+        node.objectCapacity = newCapacity;
+    }
+    uint32_t slot = node.objectCount++;
+    m_objects.set(node.firstObject + slot, obj);
+
+    if (m_wastedObjectSlots > 1024 && m_wastedObjectSlots > m_objects.size() / 2)
+        compactObjects();
+    return slot;
+}
+
+void Octree::compactObjects() {
+    // Repack every slice tightly in node order
+    ObjectStore packed;
+    packed.reserve(m_objectCount);
+    for (auto& node : m_nodes) {
+        uint32_t first = static_cast<uint32_t>(packed.size());
+        packed.append(m_objects, node.firstObject, node.objectCount);
+        node.firstObject = first;
+        node.objectCapacity = node.objectCount;
+    }
+    m_objects.swap(packed);
+    m_wastedObjectSlots = 0;
+}
+
+void Octree::removeSlot(uint32_t nodeIndex, uint32_t slot) {
+    // Swap-and-pop: move the node's last object into the freed slot
+    Node& node = m_nodes[nodeIndex];
+    uint32_t last = node.objectCount - 1;
+    if (slot != last) {
+        m_objects.set(node.firstObject + slot, m_objects.get(node.firstObject + last));
+        m_handles[m_objects.id[node.firstObject + slot]].slot = slot;
+    }
+    node.objectCount = last;
+}
+
+void Octree::detach(HandleMap::iterator handle) {
+    uint32_t nodeIndex = handle->second.node;
+    removeSlot(nodeIndex, handle->second.slot);
+    addToSubtreeCounts(nodeIndex, -1);
+    m_handles.erase(handle);
+    --m_objectCount;
 }
 
 void Octree::remove(int objectId) {
-    m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(), [objectId](const SceneObject& o) { return o.id == objectId; }), m_objects.end());
-    for (auto& child : m_children) {
-        if (child) child->remove(objectId);
+    ensureHandles();
+    auto it = m_handles.find(objectId);
+    if (it == m_handles.end())
+        return;
+    releaseImage();
+    m_revision = nextRevision();
+    uint32_t nodeIndex = it->second.node;
+    detach(it);
+    mergeUpwards(nodeIndex);
+}
+
+bool Octree::update(int objectId, const glm::vec3& newPosition, float newRadius) {
+    ensureHandles();
+    auto it = m_handles.find(objectId);
+    if (it == m_handles.end())
+        return false;
+    releaseImage();
+    m_revision = nextRevision();
+
+    uint32_t current = it->second.node;
+    SceneObject obj = m_objects.get(m_nodes[current].firstObject + it->second.slot);
+    obj.position = newPosition;
+    obj.boundingRadius = newRadius;
+
+    // Nearest ancestor whose cell holds the center and whose loose bounds hold the
+    // sphere; descending from there lands where a fresh insert from the root would
+    uint32_t start = current;
+    while (start != 0 && !canHold(m_nodes[start], obj))
+        start = m_nodes[start].parent;
+
+    if (start == current && descendChild(m_nodes[current], obj) < 0 && (current != 0 || canHold(m_nodes[0], obj))) {
+        m_objects.set(m_nodes[current].firstObject + it->second.slot, obj);
+        includeInAncestors(current, obj);
+        return true;
+    }
+
+    if (start == 0 && !canHold(m_nodes[0], obj)) {
+        // Growing renumbers nodes, so finish with the old node before it
+        detach(it);
+        mergeUpwards(current);
+        growToFit(obj);
+        place(0, obj);
+        return true;
     }
+
+    // Placing never frees nodes, so current is still valid for the merge check
+    detach(it);
+    place(start, obj);
+    mergeUpwards(current);
+    return true;
 }
 
 void Octree::query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const {
-    // Check if this node is outside query bounds
-    glm::vec3 nodeMin = m_center - glm::vec3(m_halfSize);
-    glm::vec3 nodeMax = m_center + glm::vec3(m_halfSize);
-    if (nodeMax.x < min.x || nodeMin.x > max.x || nodeMax.y < min.y || nodeMin.y > max.y || nodeMax.z < min.z || nodeMin.z > max.z)
-        return;
-    // Add objects in this node
-    for (const auto& obj : m_objects) {
-        if (obj.position.x >= min.x && obj.position.x <= max.x &&
-            obj.position.y >= min.y && obj.position.y <= max.y &&
-            obj.position.z >= min.z && obj.position.z <= max.z) {
-            results.push_back(obj.id);
-        }
-    }
-    // Query children
-    for (const auto& child : m_children) {
-        if (child) child->query(min, max, results);
+    AppendToVector visit = { results };
+    query(min, max, visit);
+}
+
+void Octree::queryFrustum(const Frustum& frustum, std::vector<int>& results) const {
+    AppendToVector visit = { results };
+    queryFrustum(frustum, visit);
+}
+
+void Octree::queryFrustumChanges(const Frustum& frustum, CullCache& cache, std::vector<int>& becameVisible,
+                                 std::vector<int>& becameHidden) const {
+    const View view = currentView();
+    ++view.counters->queries;
+    if (cache.revision != m_revision) {
+        fullCullPass(view, frustum, cache, becameVisible, becameHidden);
+        return;
+    }
+    // A point within radius of center moves, relative to plane i, by at most
+    // |delta n| * radius plus the change in the plane's distance from center
+    double movement = 0.0;
+    for (int i = 0; i < Frustum::PlaneCount; ++i) {
+        const glm::vec4& before = cache.frustum.planes[i];
+        const glm::vec4& after = frustum.planes[i];
+        double normalChange = glm::length(glm::vec3(after) - glm::vec3(before));
+        double offsetChange = std::fabs(static_cast<double>(glm::dot(glm::vec3(after), cache.center) + after.w) -
+                                        static_cast<double>(glm::dot(glm::vec3(before), cache.center) + before.w));
+        movement = std::max(movement, normalChange * cache.radius + offsetChange);
+    }
+    // Margins come from float plane tests, so pad the bound for their rounding
+    if (movement > 0.0)
+        cache.drift += movement * 1.001 + cache.radius * 1e-6;
+    cache.frustum = frustum;
+    cullChangesNode(view, 0, frustum, cache, becameVisible, becameHidden);
+}
+
+void Octree::fullCullPass(const View& view, const Frustum& frustum, CullCache& cache, std::vector<int>& becameVisible,
+                          std::vector<int>& becameHidden) const {
+    std::vector<int> previous;
+    for (size_t slot = 0; slot < cache.visible.size(); ++slot) {
+        if (cache.visible[slot]) previous.push_back(cache.slotIds[slot]);
+    }
+
+    const Node& root = view.nodes[0];
+    cache.revision = m_revision;
+    cache.frustum = frustum;
+    cache.center = hasBounds(root) ? (root.boundsMin + root.boundsMax) * 0.5f : glm::vec3(0.0f);
+    cache.radius = hasBounds(root) ? glm::length(root.boundsMax - root.boundsMin) * 0.5f : 0.0f;
+    cache.drift = 0.0;
+    const CullCache::NodeState untested = { 0.0, 0.0, Frustum::Intersecting };
+    cache.nodes.assign(view.nodeCount, untested);
+    cache.visible.assign(view.objectSlots, 0);
+    cache.expiresAt.assign(view.objectSlots, 0.0);
+    cache.slotIds.assign(view.id, view.id + view.objectSlots);
+
+    // With every flag cleared the pass only reports objects becoming visible
+    std::vector<int> current;
+    std::vector<int> none;
+    cullChangesNode(view, 0, frustum, cache, current, none);
+
+    std::sort(previous.begin(), previous.end());
+    std::sort(current.begin(), current.end());
+    std::set_difference(current.begin(), current.end(), previous.begin(), previous.end(), std::back_inserter(becameVisible));
+    std::set_difference(previous.begin(), previous.end(), current.begin(), current.end(), std::back_inserter(becameHidden));
+}
+
+void Octree::cullChangesNode(const View& view, uint32_t nodeIndex, const Frustum& frustum, CullCache& cache,
+                             std::vector<int>& becameVisible, std::vector<int>& becameHidden) const {
+    CullCache::NodeState& state = cache.nodes[nodeIndex];
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    // Until the planes have moved far enough to change the classification, a subtree
+    // inside or outside has nothing to report and a straddling node only needs its
+    // objects and children checked
+    if (cache.drift >= state.expiresAt) {
+        float margin = std::numeric_limits<float>::infinity();
+        Frustum::Containment containment = hasBounds(node) ? frustum.classifyBox(node.boundsMin, node.boundsMax, margin) : Frustum::Outside;
+        if (containment != Frustum::Intersecting && containment != state.containment) {
+            markSubtree(view, nodeIndex, containment, margin, cache, becameVisible, becameHidden);
+            return;
+        }
+        // Unchanged inside or outside: the subtree's flags are already right and its
+        // older states remain valid
+        state.expiresAt = cache.drift + margin;
+        state.containment = containment;
+    }
+    if (state.containment != Frustum::Intersecting)
+        return;
+
+    if (cache.drift >= state.objectsExpireAt)
+        cullChangesObjects(view, nodeIndex, frustum, cache, becameVisible, becameHidden);
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) cullChangesNode(view, node.firstChild + i, frustum, cache, becameVisible, becameHidden);
+    }
+}
+
+void Octree::cullChangesObjects(const View& view, uint32_t nodeIndex, const Frustum& frustum, CullCache& cache,
+                                std::vector<int>& becameVisible, std::vector<int>& becameHidden) const {
+    const Node& node = view.nodes[nodeIndex];
+    double earliest = std::numeric_limits<double>::infinity();
+    const uint32_t first = node.firstObject;
+    for (uint32_t slot = first; slot < first + node.objectCount; ++slot) {
+        if (cache.drift < cache.expiresAt[slot]) {
+            earliest = std::min(earliest, cache.expiresAt[slot]);
+            continue;
+        }
+        ++view.counters->objectsTested;
+        // Same test as intersectsSphere, keeping the distance to the nearest deciding plane:
+        // how far a visible sphere is from leaving and a hidden one from entering
+        const glm::vec3 center(view.x[slot], view.y[slot], view.z[slot]);
+        float nearestInside = std::numeric_limits<float>::max();
+        float deepestOutside = 0.0f;
+        for (const auto& plane : frustum.planes) {
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w + view.radius[slot];
+            if (distance < 0.0f) deepestOutside = std::max(deepestOutside, -distance);
+            else nearestInside = std::min(nearestInside, distance);
+        }
+        const uint8_t visible = deepestOutside > 0.0f ? 0 : 1;
+        cache.expiresAt[slot] = cache.drift + (visible ? nearestInside : deepestOutside);
+        earliest = std::min(earliest, cache.expiresAt[slot]);
+        if (visible != cache.visible[slot]) {
+            cache.visible[slot] = visible;
+            (visible ? becameVisible : becameHidden).push_back(view.id[slot]);
+        }
+    }
+    cache.nodes[nodeIndex].objectsExpireAt = earliest;
+}
+
+void Octree::markSubtree(const View& view, uint32_t nodeIndex, Frustum::Containment containment, float margin,
+                         CullCache& cache, std::vector<int>& becameVisible, std::vector<int>& becameHidden) const {
+    // A child's box lies inside its parent's, so it is at least as far from every plane
+    CullCache::NodeState& state = cache.nodes[nodeIndex];
+    state.expiresAt = cache.drift + margin;
+    state.objectsExpireAt = state.expiresAt;
+    state.containment = containment;
+
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    const uint8_t visible = containment == Frustum::Inside ? 1 : 0;
+    std::vector<int>& changes = visible ? becameVisible : becameHidden;
+    const uint32_t first = node.firstObject;
+    for (uint32_t slot = first; slot < first + node.objectCount; ++slot) {
+        cache.expiresAt[slot] = state.expiresAt;
+        if (cache.visible[slot] != visible) {
+            cache.visible[slot] = visible;
+            changes.push_back(view.id[slot]);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) markSubtree(view, node.firstChild + i, containment, margin, cache, becameVisible, becameHidden);
+    }
+}
+
+bool Octree::rayEntersNode(const Node& node, const Ray& ray, float maxDistance, float& entry) {
+    return hasBounds(node) && IntersectRayBox(ray.origin, ray.inverseDirection, node.boundsMin, node.boundsMax, maxDistance, entry);
+}
+
+bool Octree::raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, float maxDistance) const {
+    const View view = currentView();
+    float length = glm::length(direction);
+    if (length <= 0.0f)
+        return false;
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = direction / length;
+    ray.inverseDirection = 1.0f / ray.direction;
+
+    ++view.counters->queries;
+    float entry;
+    if (!rayEntersNode(view.nodes[0], ray, maxDistance, entry))
+        return false;
+    RayHit best = { -1, maxDistance };
+    bool found = false;
+    raycastFirstNode(view, 0, ray, best, found);
+    if (found)
+        hit = best;
+    return found;
+}
+
+int Octree::orderChildrenAlongRay(const View& view, const Node& node, const Ray& ray, float maxDistance, float entries[8], uint32_t order[8]) const {
+    int count = 0;
+    for (int c = 0; c < 8; ++c) {
+        float enter;
+        if (!(node.childMask & (1u << c)) || !rayEntersNode(view.nodes[node.firstChild + c], ray, maxDistance, enter))
+            continue;
+        // Insertion sort over at most eight entries
+        int k = count++;
+        for (; k > 0 && entries[k - 1] > enter; --k) {
+            entries[k] = entries[k - 1];
+            order[k] = order[k - 1];
+        }
+        entries[k] = enter;
+        order[k] = node.firstChild + c;
+    }
+    return count;
+}
+
+void Octree::raycastFirstNode(const View& view, uint32_t nodeIndex, const Ray& ray, RayHit& best, bool& found) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    view.counters->objectsTested += node.objectCount;
+    for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; ++i) {
+        float distance;
+        if (IntersectRaySphere(ray.origin, ray.direction, glm::vec3(view.x[i], view.y[i], view.z[i]), view.radius[i], best.distance, distance)
+            && (!found || distance < best.distance)) {
+            best.id = view.id[i];
+            best.distance = distance;
+            found = true;
+        }
+    }
+    if (node.childMask == 0)
+        return;
+
+    float entries[8];
+    uint32_t order[8];
+    int count = orderChildrenAlongRay(view, node, ray, best.distance, entries, order);
+    for (int k = 0; k < count; ++k) {
+        // Child bounds overlap, so a later child can still hold a nearer sphere until its entry passes the best hit
+        if (entries[k] > best.distance)
+            break;
+        raycastFirstNode(view, order[k], ray, best, found);
+    }
+}
+
+void Octree::raycastAll(const glm::vec3& origin, const glm::vec3& direction, std::vector<RayHit>& hits, float maxDistance) const {
+    const View view = currentView();
+    hits.clear();
+    float length = glm::length(direction);
+    if (length <= 0.0f)
+        return;
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = direction / length;
+    ray.inverseDirection = 1.0f / ray.direction;
+
+    ++view.counters->queries;
+    float entry;
+    if (rayEntersNode(view.nodes[0], ray, maxDistance, entry))
+        raycastAllNode(view, 0, ray, maxDistance, hits);
+    std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    });
+}
+
+void Octree::raycastAllNode(const View& view, uint32_t nodeIndex, const Ray& ray, float maxDistance, std::vector<RayHit>& hits) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    view.counters->objectsTested += node.objectCount;
+    for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; ++i) {
+        float distance;
+        if (IntersectRaySphere(ray.origin, ray.direction, glm::vec3(view.x[i], view.y[i], view.z[i]), view.radius[i], maxDistance, distance))
+            hits.push_back(RayHit{ view.id[i], distance });
+    }
+    if (node.childMask == 0)
+        return;
+    float entries[8];
+    uint32_t order[8];
+    int count = orderChildrenAlongRay(view, node, ray, maxDistance, entries, order);
+    for (int k = 0; k < count; ++k) raycastAllNode(view, order[k], ray, maxDistance, hits);
+}
+
+void Octree::queryNearest(const glm::vec3& point, size_t k, std::vector<Neighbor>& results) const {
+    const View view = currentView();
+    results.clear();
+    ++view.counters->queries;
+    if (k == 0 || m_objectCount == 0)
+        return;
+    nearestNode(view, 0, point, k, results);
+    std::sort_heap(results.begin(), results.end(), closerNeighbor);
+}
+
+void Octree::nearestNode(const View& view, uint32_t nodeIndex, const glm::vec3& point, size_t k, std::vector<Neighbor>& heap) const {
+    // heap is a max-heap on distance holding the best k so far; its front is the bound
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    view.counters->objectsTested += node.objectCount;
+    for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; ++i) {
+        Neighbor candidate = { view.id[i],
+            std::max(glm::length(point - glm::vec3(view.x[i], view.y[i], view.z[i])) - view.radius[i], 0.0f) };
+        if (heap.size() < k) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), closerNeighbor);
+        } else if (closerNeighbor(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), closerNeighbor);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), closerNeighbor);
+        }
+    }
+    if (node.childMask == 0)
+        return;
+
+    // The distance to a child's bounds is a lower bound for anything below it
+    float distances[8];
+    uint32_t order[8];
+    int count = 0;
+    for (int c = 0; c < 8; ++c) {
+        if (!(node.childMask & (1u << c)))
+            continue;
+        const Node& child = view.nodes[node.firstChild + c];
+        if (!hasBounds(child))
+            continue;
+        float distanceSq = boxDistanceSq(point, child.boundsMin, child.boundsMax);
+        int slot = count++;
+        for (; slot > 0 && distances[slot - 1] > distanceSq; --slot) {
+            distances[slot] = distances[slot - 1];
+            order[slot] = order[slot - 1];
+        }
+        distances[slot] = distanceSq;
+        order[slot] = node.firstChild + c;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (heap.size() == k && distances[i] > heap.front().distance * heap.front().distance)
+            break;
+        nearestNode(view, order[i], point, k, heap);
+    }
+}
+
+void Octree::querySphere(const glm::vec3& center, float radius, std::vector<int>& results) const {
+    const View view = currentView();
+    ++view.counters->queries;
+    if (hasBounds(view.nodes[0]) && boxDistanceSq(center, view.nodes[0].boundsMin, view.nodes[0].boundsMax) <= radius * radius)
+        querySphereNode(view, 0, center, radius, results);
+}
+
+void Octree::querySphereNode(const View& view, uint32_t nodeIndex, const glm::vec3& center, float radius, std::vector<int>& results) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    view.counters->objectsTested += node.objectCount;
+    for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; ++i) {
+        glm::vec3 offset = glm::vec3(view.x[i], view.y[i], view.z[i]) - center;
+        float reach = radius + view.radius[i];
+        if (glm::dot(offset, offset) <= reach * reach)
+            results.push_back(view.id[i]);
+    }
+    for (int c = 0; c < 8; ++c) {
+        if (!(node.childMask & (1u << c)))
+            continue;
+        const Node& child = view.nodes[node.firstChild + c];
+        if (hasBounds(child) && boxDistanceSq(center, child.boundsMin, child.boundsMax) <= radius * radius)
+            querySphereNode(view, node.firstChild + c, center, radius, results);
+    }
+}
+
+struct Octree::PairTask {
+    enum Kind { Self, Own, Cross };
+    Kind kind;
+    uint32_t a;
+    uint32_t b; // Second subtree of a Cross task
+};
+
+void Octree::queryOverlappingPairs(std::vector<std::pair<int, int> >& pairs, int threadCount) const {
+    const View view = currentView();
+    ++view.counters->queries;
+    threadCount = ResolveThreadCount(threadCount);
+    if (threadCount == 1) {
+        selfPairs(view, 0, pairs);
+        return;
+    }
+
+    // Two levels give up to 64 subtree tasks plus the sibling crossings above them
+    std::vector<PairTask> tasks;
+    planPairTasks(view, 0, 0, 2, tasks);
+    std::vector<std::vector<std::pair<int, int> > > results(tasks.size());
+    ParallelForEach(tasks.size(), threadCount, [&](size_t t) {
+        // Each worker counts into its own thread's counters
+        View local = view;
+        local.counters = &t_queryCounters;
+        const PairTask& task = tasks[t];
+        if (task.kind == PairTask::Self) selfPairs(local, task.a, results[t]);
+        else if (task.kind == PairTask::Own) ownPairs(local, task.a, results[t]);
+        else crossPairs(local, task.a, task.b, results[t]);
+    });
+    for (const auto& result : results) pairs.insert(pairs.end(), result.begin(), result.end());
+}
+
+void Octree::planPairTasks(const View& view, uint32_t nodeIndex, int depth, int splitDepth, std::vector<PairTask>& tasks) const {
+    const Node& node = view.nodes[nodeIndex];
+    if (depth == splitDepth || node.childMask == 0) {
+        tasks.push_back(PairTask{ PairTask::Self, nodeIndex, 0 });
+        return;
+    }
+    // Same split as selfPairs, one task per piece
+    tasks.push_back(PairTask{ PairTask::Own, nodeIndex, 0 });
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) planPairTasks(view, node.firstChild + i, depth + 1, splitDepth, tasks);
+    }
+    for (int i = 0; i < 8; ++i) {
+        for (int j = i + 1; j < 8; ++j) {
+            if ((node.childMask & (1u << i)) && (node.childMask & (1u << j)))
+                tasks.push_back(PairTask{ PairTask::Cross, node.firstChild + i, node.firstChild + j });
+        }
+    }
+}
+
+void Octree::selfPairs(const View& view, uint32_t nodeIndex, std::vector<std::pair<int, int> >& pairs) const {
+    const Node& node = view.nodes[nodeIndex];
+    if (!hasBounds(node))
+        return;
+    ownPairs(view, nodeIndex, pairs);
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) selfPairs(view, node.firstChild + i, pairs);
+    }
+    // Loose bounds let spheres in sibling subtrees overlap
+    for (int i = 0; i < 8; ++i) {
+        if (!(node.childMask & (1u << i)))
+            continue;
+        for (int j = i + 1; j < 8; ++j) {
+            if (node.childMask & (1u << j)) crossPairs(view, node.firstChild + i, node.firstChild + j, pairs);
+        }
+    }
+}
+
+void Octree::ownPairs(const View& view, uint32_t nodeIndex, std::vector<std::pair<int, int> >& pairs) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    if (node.objectCount == 0)
+        return;
+    const uint32_t first = node.firstObject;
+    const uint32_t end = first + node.objectCount;
+    glm::vec3 sliceMin(std::numeric_limits<float>::max());
+    glm::vec3 sliceMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = first; i < end; ++i) {
+        const glm::vec3 center(view.x[i], view.y[i], view.z[i]);
+        sliceMin = glm::min(sliceMin, center - view.radius[i]);
+        sliceMax = glm::max(sliceMax, center + view.radius[i]);
+        for (uint32_t j = i + 1; j < end; ++j) {
+            const glm::vec3 offset = glm::vec3(view.x[j], view.y[j], view.z[j]) - center;
+            const float reach = view.radius[i] + view.radius[j];
+            if (glm::dot(offset, offset) <= reach * reach)
+                pairs.push_back(std::make_pair(std::min(view.id[i], view.id[j]), std::max(view.id[i], view.id[j])));
+        }
+    }
+    view.counters->objectsTested += node.objectCount;
+    for (int c = 0; c < 8; ++c) {
+        if (node.childMask & (1u << c)) slicePairs(view, nodeIndex, sliceMin, sliceMax, node.firstChild + c, pairs);
+    }
+}
+
+void Octree::crossPairs(const View& view, uint32_t a, uint32_t b, std::vector<std::pair<int, int> >& pairs) const {
+    const Node& nodeA = view.nodes[a];
+    const Node& nodeB = view.nodes[b];
+    ++view.counters->nodesVisited;
+    if (!hasBounds(nodeA) || !hasBounds(nodeB) || !boxesOverlap(nodeA.boundsMin, nodeA.boundsMax, nodeB.boundsMin, nodeB.boundsMax))
+        return;
+    // Objects held at a or b themselves against the whole other subtree, then the
+    // children of both against each other
+    if (nodeA.objectCount > 0) slicePairs(view, a, nodeA.boundsMin, nodeA.boundsMax, b, pairs);
+    if (nodeB.objectCount > 0) {
+        for (int j = 0; j < 8; ++j) {
+            if (nodeA.childMask & (1u << j)) slicePairs(view, b, nodeB.boundsMin, nodeB.boundsMax, nodeA.firstChild + j, pairs);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (!(nodeA.childMask & (1u << i)))
+            continue;
+        for (int j = 0; j < 8; ++j) {
+            if (nodeB.childMask & (1u << j)) crossPairs(view, nodeA.firstChild + i, nodeB.firstChild + j, pairs);
+        }
+    }
+}
+
+void Octree::slicePairs(const View& view, uint32_t owner, const glm::vec3& sliceMin, const glm::vec3& sliceMax, uint32_t nodeIndex,
+                        std::vector<std::pair<int, int> >& pairs) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    if (!hasBounds(node) || !boxesOverlap(sliceMin, sliceMax, node.boundsMin, node.boundsMax))
+        return;
+    const Node& slice = view.nodes[owner];
+    for (uint32_t j = node.firstObject; j < node.firstObject + node.objectCount; ++j) {
+        const glm::vec3 center(view.x[j], view.y[j], view.z[j]);
+        for (uint32_t i = slice.firstObject; i < slice.firstObject + slice.objectCount; ++i) {
+            const glm::vec3 offset = glm::vec3(view.x[i], view.y[i], view.z[i]) - center;
+            const float reach = view.radius[i] + view.radius[j];
+            if (glm::dot(offset, offset) <= reach * reach)
+                pairs.push_back(std::make_pair(std::min(view.id[i], view.id[j]), std::max(view.id[i], view.id[j])));
+        }
+    }
+    view.counters->objectsTested += node.objectCount;
+    for (int c = 0; c < 8; ++c) {
+        if (node.childMask & (1u << c)) slicePairs(view, owner, sliceMin, sliceMax, node.firstChild + c, pairs);
     }
 }
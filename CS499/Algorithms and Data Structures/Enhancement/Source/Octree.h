@@ -1,31 +1,443 @@
 #pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
+#include <unordered_map>
 #include <glm/glm.hpp>
-#include <memory>
+#include "AlignedAllocator.h"
+#include "Frustum.h"
+#include "OctreeLeafScan.h"
+#include "SpatialIndex.h"
+
+class MappedFile;
+
+struct Neighbor {
+    int id;
+    float distance; // From the query point to the bounding sphere's surface; 0 inside it
+};
+
+// Shape and memory use of an Octree, gathered by Octree::computeStats
+struct OctreeStats {
+    size_t nodeCount;                    // Nodes reachable from the root
+    size_t leafCount;                    // Nodes without children
+    size_t emptyNodeCount;               // Nodes that hold no objects of their own
+    size_t emptyLeafCount;
+    size_t objectCount;
+    size_t maxObjectsPerLeaf;
+    double averageObjectsPerLeaf;
+    std::vector<size_t> nodesPerDepth;   // Indexed by depth, root = 0
+    std::vector<size_t> objectsPerDepth;
+    size_t pooledNodes;                  // Node pool size, including blocks freed by merges
+    size_t wastedObjectSlots;            // Object array entries no node owns
+    size_t bytesUsed;                    // Node pool, object arrays, free list and an estimate of the id map
+};
 
-struct SceneObject {
-    glm::vec3 position;
-    float boundingRadius;
-    int id; // Unique identifier
+// Work done by Octree queries, summed per thread over every tree it queried
+struct OctreeQueryCounters {
+    uint64_t queries;
+    uint64_t nodesVisited;   // Nodes reached, including those pruned by their bounds
+    uint64_t objectsTested;  // Objects tested one by one; subtrees accepted whole add none
 };
 
-class Octree {
+/***********************************************************
+ *  Octree
+ *
+ *  Loose octree: each cell's bounds are enlarged by the
+ *  looseness factor, and an object descends only while its
+ *  bounding sphere fits inside the next child's loose bounds.
+ *  With looseness 2 the storage depth follows the radius;
+ *  looseness 1 gives a classic octree where objects that
+ *  straddle a split plane stay in the parent.
+ *
+ *  Subdivision follows occupancy: a node only splits once it
+ *  holds more than splitThreshold objects, and a subtree that
+ *  drops to mergeThreshold objects or fewer is folded back
+ *  into its root. A split threshold of 0 pushes every object
+ *  as deep as it fits.
+ *
+ *  The root grows on demand: an object whose center falls
+ *  outside it re-parents the tree under a root twice the
+ *  size, with the old root as one of its octants. The depth
+ *  limit grows with it so leaf cells keep their size.
+ *
+ *  Nodes live in one contiguous pool addressed by 32-bit
+ *  indices; children are allocated as a block of eight and
+ *  tracked by a bitmask. Each node also keeps a box around
+ *  every sphere in its subtree, which queries prune with;
+ *  the box only grows, so after removals it stays a safe
+ *  (if looser) bound. Objects live in shared packed
+ *  arrays where each node owns one slice; positions, radii
+ *  and ids are stored as separate arrays so leaf tests can
+ *  check eight objects per SIMD instruction.
+ *
+ *  Nodes and objects hold indices rather than pointers, so a
+ *  tree can be saved as one binary image and later mapped
+ *  back in. Queries read the mapped image in place; the
+ *  first edit copies it into memory.
+ ***********************************************************/
+class Octree : public SpatialIndex {
 public:
-    Octree(const glm::vec3& center, float halfSize, int depth = 0, int maxDepth = 5);
-    ~Octree();
+    Octree(const glm::vec3& center, float halfSize, int maxDepth = 5, float looseness = 2.0f,
+           int splitThreshold = 8, int mergeThreshold = 4);
+
+    // Replace the contents with a batch of objects (ids must be unique). Objects are
+    // sorted by 30-bit Morton code with a radix sort and the tree is laid out from
+    // that order in one depth-first pass, with no per-object descent. With threadCount
+    // above 1 (0 = all hardware threads) subtrees under the top one or two levels are
+    // built in parallel and spliced back in serial order, so the tree is identical.
+    void build(const std::vector<SceneObject>& objects, int threadCount = 1) override;
+    // Inserting an id that is already present replaces the old entry. The root is
+    // grown first if it cannot hold the object.
+    void insert(const SceneObject& obj) override;
+    // Looks up the owning node by id and swap-and-pops the slot, then folds the
+    // highest ancestor subtree left with mergeThreshold objects or fewer
+    void remove(int objectId) override;
+    // Move/resize an object in place when it still belongs to its node, otherwise
+    // climb only to the nearest ancestor that can hold it. Returns false for unknown ids.
+    bool update(int objectId, const glm::vec3& newPosition, float newRadius) override;
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const override;
+    // Bounding-sphere test against the six frustum planes; nodes fully inside accept their whole subtree
+    void queryFrustum(const Frustum& frustum, std::vector<int>& results) const override;
+    // Visitor forms of query and queryFrustum: visit(id) is called once per result instead
+    // of appending to a vector. The traversal is a template, so the visitor is inlined and
+    // nothing is allocated; pass an IdSpan to collect into a caller-owned buffer.
+    template <typename F>
+    void query(const glm::vec3& min, const glm::vec3& max, F&& visit) const;
+    template <typename F>
+    void queryFrustum(const Frustum& frustum, F&& visit) const;
 
-    void insert(const SceneObject& obj);
-    void remove(int objectId);
-    void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const;
-    void clear();
+    // Culling state kept between frames by queryFrustumChanges; use one per camera.
+    // Each node and object remembers its last classification and the drift at which
+    // the frustum planes may have moved far enough to change it.
+    struct CullCache {
+        struct NodeState {
+            double expiresAt;                 // Re-classify once drift reaches this
+            double objectsExpireAt;           // Earliest re-test among the node's own objects
+            Frustum::Containment containment;
+        };
+
+        uint64_t revision;                    // Tree revision at the last full pass, 0 before it
+        Frustum frustum;                      // Frustum of the previous call
+        glm::vec3 center;                     // Sphere around the root bounds; a plane change
+        float radius;                         // moves no point inside it further than the bound
+        double drift;                         // Sum of per-call movement bounds since the full pass
+        std::vector<NodeState> nodes;
+        std::vector<uint8_t> visible;         // Per object slot: reported visible
+        std::vector<double> expiresAt;        // Per object slot: drift at which to re-test it
+        std::vector<int> slotIds;             // Per object slot: id at the last full pass
+
+        CullCache() : revision(0), center(0.0f), radius(0.0f), drift(0.0) {}
+    };
+    // Frustum query that reports only what changed since the previous call with this
+    // cache: ids that became visible and ids that became hidden are appended to the two
+    // lists. Subtrees last found fully inside or outside, and objects inside partly
+    // visible nodes, are skipped until the planes have moved further than their distance
+    // from the boundary, so a camera that moves a little each frame only re-tests what
+    // lies near the frustum's edges. The first call, a tree with other contents or any
+    // edit since the last call falls back to a full pass diffed against the old set.
+    void queryFrustumChanges(const Frustum& frustum, CullCache& cache, std::vector<int>& becameVisible,
+                             std::vector<int>& becameHidden) const;
+    // Nearest bounding sphere hit by origin + t * direction for 0 <= t <= maxDistance.
+    // Nodes are visited front-to-back by entry distance and skipped once they start
+    // beyond the best hit so far. Returns false when nothing is hit.
+    bool raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                      float maxDistance = std::numeric_limits<float>::max()) const override;
+    // Every bounding sphere the ray passes through, nearest first
+    void raycastAll(const glm::vec3& origin, const glm::vec3& direction, std::vector<RayHit>& hits,
+                    float maxDistance = std::numeric_limits<float>::max()) const;
+    // The k objects whose bounding spheres are closest to point, nearest first. Children
+    // are searched nearest-first and skipped once they are farther than the k-th best;
+    // results doubles as the bounded max-heap, so a reused vector never reallocates.
+    void queryNearest(const glm::vec3& point, size_t k, std::vector<Neighbor>& results) const;
+    // Objects whose bounding sphere overlaps the sphere (center, radius)
+    void querySphere(const glm::vec3& center, float radius, std::vector<int>& results) const;
+    // Every pair of objects whose bounding spheres overlap or touch, once each as
+    // (smaller id, larger id), appended to pairs. One traversal of the tree against
+    // itself: a node's objects are tested against each other and its subtree, and
+    // sibling subtrees against each other only where their bounds overlap. The top
+    // levels are cut into independent tasks run on threadCount threads (0 = all
+    // hardware threads); results are joined in task order, so the output does not
+    // depend on the thread count.
+    void queryOverlappingPairs(std::vector<std::pair<int, int> >& pairs, int threadCount = 1) const;
+    // Walks the tree from the root; cost is linear in the node count
+    OctreeStats computeStats() const;
+    // The calling thread's query counters. They are per thread, so concurrent readers
+    // never contend on them; take a copy before and after a query to see its cost.
+    static const OctreeQueryCounters& queryCounters();
+    // Drops every node and object in one reset; pool capacity and any growth of the
+    // root are kept for reuse
+    void clear() override;
+    size_t size() const override { return m_objectCount; }
+    bool contains(int objectId) const override;
+    const char* name() const override { return "Octree"; }
+    // Write the tree as a versioned binary image with packed object slices. The image
+    // stores indices only, but assumes the byte order and Node layout of this build.
+    // Returns false if the file cannot be written.
+    bool save(const std::string& path) const;
+    // Map an image written by save and answer queries straight from it, so startup only
+    // pays for the pages queries touch. The tree takes the saved bounds, depth and
+    // thresholds. Returns false, leaving the tree as it was, if the file is missing or
+    // was written by a different version or layout.
+    bool load(const std::string& path);
 
 private:
-    glm::vec3 m_center;
-    float m_halfSize;
-    int m_depth;
+    // Prepares published snapshots for concurrent readers and keeps its two copies in step
+    friend class ConcurrentOctree;
+
+    static const uint32_t kInvalidIndex = 0xFFFFFFFFu;
+    static const int kMaxSupportedDepth = 10; // Morton codes carry 10 bits per axis
+    static const int kMaxRootGrowth = 32;     // Doublings tried for one object before it is left at the root
+
+    struct Node {
+        glm::vec3 center;
+        float halfSize;
+        glm::vec3 boundsMin;     // Box around every sphere in this subtree; min > max while empty
+        glm::vec3 boundsMax;
+        uint32_t parent;
+        uint32_t firstChild;     // Start of this node's block of eight children, kInvalidIndex while unsplit
+        uint32_t firstObject;    // Start of this node's slice of m_objects
+        uint32_t objectCount;
+        uint32_t objectCapacity;
+        uint32_t subtreeCount;   // Objects stored in this node and all its descendants
+        uint8_t childMask;       // Bit i set when child i is in use
+        uint8_t depth;
+    };
+
+    // Where an object lives: owning node and index within that node's slice
+    struct ObjectHandle {
+        uint32_t node;
+        uint32_t slot;
+    };
+
+    // Object tagged with its Morton code while a bulk build sorts and splits it
+    struct BuildEntry {
+        uint32_t code;
+        SceneObject object;
+    };
+
+    typedef std::unordered_map<int, ObjectHandle> HandleMap;
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;        // Normalized
+        glm::vec3 inverseDirection;
+    };
+
+    // SceneObject fields as parallel 32-byte aligned arrays, indexed together
+    struct ObjectStore {
+        typedef std::vector<float, AlignedAllocator<float, 32> > FloatArray;
+        typedef std::vector<int, AlignedAllocator<int, 32> > IntArray;
+
+        FloatArray x, y, z, radius;
+        IntArray id;
+
+        size_t size() const { return id.size(); }
+        void clear() { x.clear(); y.clear(); z.clear(); radius.clear(); id.clear(); }
+        void reserve(size_t count) { x.reserve(count); y.reserve(count); z.reserve(count); radius.reserve(count); id.reserve(count); }
+        void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); radius.resize(count); id.resize(count); }
+        void swap(ObjectStore& other) { x.swap(other.x); y.swap(other.y); z.swap(other.z); radius.swap(other.radius); id.swap(other.id); }
+
+        SceneObject get(size_t i) const { return SceneObject{ glm::vec3(x[i], y[i], z[i]), radius[i], id[i] }; }
+        void set(size_t i, const SceneObject& obj) { x[i] = obj.position.x; y[i] = obj.position.y; z[i] = obj.position.z; radius[i] = obj.boundingRadius; id[i] = obj.id; }
+        void push_back(const SceneObject& obj) { x.push_back(obj.position.x); y.push_back(obj.position.y); z.push_back(obj.position.z); radius.push_back(obj.boundingRadius); id.push_back(obj.id); }
+        // Copy count objects from source[first] to this[dest]; the ranges must not overlap
+        void copyFrom(const ObjectStore& source, size_t first, size_t count, size_t dest);
+        void append(const ObjectStore& source, size_t first, size_t count);
+    };
+
+    // Read-only access to the node pool and object arrays, either the members below
+    // or a mapped image; every query reads through this
+    struct View {
+        const Node* nodes;
+        uint32_t nodeCount;
+        uint32_t objectSlots;   // Length of the object arrays, including abandoned slices
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* radius;
+        const int* id;
+        OctreeQueryCounters* counters; // The calling thread's, set by currentView
+    };
+
+    // Parallel build bookkeeping, defined in Octree.cpp
+    struct BuildSplit;
+    struct BuildTask;
+    struct BuildPlan;
+
+    std::vector<Node> m_nodes;          // m_nodes[0] is the root
+    std::vector<uint32_t> m_freeBlocks; // Child blocks released by merges, reused by splits
+    ObjectStore m_objects;              // Packed per-node slices
+    mutable HandleMap m_handles;        // id -> (node, slot)
+    mutable bool m_handlesStale;        // Set by build(); the map is rebuilt on first use
+    size_t m_objectCount;
+    size_t m_wastedObjectSlots;         // Slices abandoned when a node outgrew them
     int m_maxDepth;
-    std::vector<SceneObject> m_objects;
-    std::unique_ptr<Octree> m_children[8];
-    bool isLeaf() const;
-    int getChildIndex(const glm::vec3& pos) const;
+    float m_looseness;
+    uint32_t m_splitThreshold;
+    uint32_t m_mergeThreshold;
+    std::shared_ptr<MappedFile> m_image; // Set by load() until the first edit
+    View m_imageView;                    // Sections of m_image, valid while it is set
+    // Identifies the contents: every edit draws a new value from a counter shared by all
+    // trees, and only copies share one, so cull caches can tell when a tree changed
+    uint64_t m_revision;
+
+    static int getChildIndex(const Node& node, const glm::vec3& pos);
+    static glm::vec3 getChildCenter(const Node& node, int idx);
+    bool atMaxDepth(const Node& node) const { return node.depth >= m_maxDepth; }
+    static bool isSplit(const Node& node) { return node.firstChild != kInvalidIndex; }
+    // Child whose loose bounds fit the object, or -1 if it must stay at this node
+    int findChildFor(const Node& node, const SceneObject& obj) const;
+    // findChildFor, but only for nodes that are already split
+    int descendChild(const Node& node, const SceneObject& obj) const { return isSplit(node) ? findChildFor(node, obj) : -1; }
+    // Center inside this cell and sphere inside its loose bounds
+    bool canHold(const Node& node, const SceneObject& obj) const;
+    Node makeNode(const glm::vec3& center, float halfSize, uint32_t parent, int depth) const;
+    uint32_t allocateChildren(std::vector<Node>& nodes, uint32_t nodeIndex) const;
+    // allocateChildren on m_nodes, reusing a freed block when there is one
+    uint32_t acquireChildBlock(uint32_t nodeIndex);
+    // Create the children and push down every object that fits one
+    void splitNode(uint32_t nodeIndex);
+    // Move every object below nodeIndex into it and release the child blocks
+    void collapseNode(uint32_t nodeIndex);
+    void pullUpObjects(uint32_t target, uint32_t nodeIndex);
+    // Collapse the highest ancestor of nodeIndex whose subtree is at or under mergeThreshold
+    void mergeUpwards(uint32_t nodeIndex);
+    // Double the root toward the object until it can hold it
+    void growToFit(const SceneObject& obj);
+    // Make the current root an octant of a new root twice its size, or rebuild
+    // under the bigger root once the depth limit cannot grow any further
+    void growRoot(const glm::vec3& toward);
+    // Descend from start to the object's node, store it there and record its handle
+    void place(uint32_t start, const SceneObject& obj);
+    void detach(HandleMap::iterator handle);
+    // Swap-and-pop one slot of a node, fixing the handle of the object moved into it
+    void removeSlot(uint32_t nodeIndex, uint32_t slot);
+    uint32_t appendToNode(uint32_t nodeIndex, const SceneObject& obj);
+    void compactObjects();
+    void ensureHandles() const;
+    View currentView() const;
+    // Copy a loaded image into the members so the tree can be edited
+    void releaseImage();
+    uint32_t mortonCode(const glm::vec3& pos) const;
+    static bool hasBounds(const Node& node) { return node.boundsMin.x <= node.boundsMax.x; }
+    static void includeObjects(Node& node, const ObjectStore& objects, uint32_t first, uint32_t count);
+    // Fold the boxes and object counts of a node's children into its own
+    static void includeChildren(std::vector<Node>& nodes, uint32_t nodeIndex);
+    // Grow the boxes from nodeIndex upwards until one already holds the sphere
+    void includeInAncestors(uint32_t nodeIndex, const SceneObject& obj);
+    void addToSubtreeCounts(uint32_t nodeIndex, int delta);
+    void finishSplitNodes(uint32_t nodeIndex, int splitDepth);
+    // Compact entries that fit their child to the front of the range and append the rest
+    // to stayers; returns the end of the fitting run
+    uint32_t splitEntries(const Node& node, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries, ObjectStore& stayers) const;
+    void buildNode(std::vector<Node>& nodes, ObjectStore& objects, uint32_t nodeIndex, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries) const;
+    void buildParallel(std::vector<BuildEntry>& entries, int threadCount);
+    void planSplit(const Node& node, uint32_t begin, uint32_t end, std::vector<BuildEntry>& entries, BuildPlan& plan) const;
+    void emitSplit(uint32_t nodeIndex, BuildPlan& plan);
+    template <typename F>
+    void queryNode(const View& view, uint32_t nodeIndex, const glm::vec3& min, const glm::vec3& max, F& visit) const;
+    template <typename F>
+    void queryFrustumNode(const View& view, uint32_t nodeIndex, const Frustum& frustum, F& visit) const;
+    template <typename F>
+    void collectAll(const View& view, uint32_t nodeIndex, F& visit) const;
+    void cullChangesNode(const View& view, uint32_t nodeIndex, const Frustum& frustum, CullCache& cache,
+                         std::vector<int>& becameVisible, std::vector<int>& becameHidden) const;
+    // Re-test the node's own objects whose margin has run out
+    void cullChangesObjects(const View& view, uint32_t nodeIndex, const Frustum& frustum, CullCache& cache,
+                            std::vector<int>& becameVisible, std::vector<int>& becameHidden) const;
+    // Give a whole subtree one classification and flip the objects whose visibility it changes
+    void markSubtree(const View& view, uint32_t nodeIndex, Frustum::Containment containment, float margin,
+                     CullCache& cache, std::vector<int>& becameVisible, std::vector<int>& becameHidden) const;
+    void fullCullPass(const View& view, const Frustum& frustum, CullCache& cache, std::vector<int>& becameVisible,
+                      std::vector<int>& becameHidden) const;
+    // Distance at which the ray enters a node's bounds, if it does so before maxDistance
+    static bool rayEntersNode(const Node& node, const Ray& ray, float maxDistance, float& entry);
+    // Children the ray enters before maxDistance, sorted by entry distance; returns the count
+    int orderChildrenAlongRay(const View& view, const Node& node, const Ray& ray, float maxDistance, float entries[8], uint32_t order[8]) const;
+    void raycastFirstNode(const View& view, uint32_t nodeIndex, const Ray& ray, RayHit& best, bool& found) const;
+    void raycastAllNode(const View& view, uint32_t nodeIndex, const Ray& ray, float maxDistance, std::vector<RayHit>& hits) const;
+    void nearestNode(const View& view, uint32_t nodeIndex, const glm::vec3& point, size_t k, std::vector<Neighbor>& heap) const;
+    void querySphereNode(const View& view, uint32_t nodeIndex, const glm::vec3& center, float radius, std::vector<int>& results) const;
+    // One independent piece of queryOverlappingPairs, defined in Octree.cpp
+    struct PairTask;
+    // Split the self-traversal of a subtree into tasks down to splitDepth
+    void planPairTasks(const View& view, uint32_t nodeIndex, int depth, int splitDepth, std::vector<PairTask>& tasks) const;
+    // Pairs within a subtree
+    void selfPairs(const View& view, uint32_t nodeIndex, std::vector<std::pair<int, int> >& pairs) const;
+    // Pairs among a node's own objects and between them and the node's descendants
+    void ownPairs(const View& view, uint32_t nodeIndex, std::vector<std::pair<int, int> >& pairs) const;
+    // Pairs with one object in each of two disjoint subtrees
+    void crossPairs(const View& view, uint32_t a, uint32_t b, std::vector<std::pair<int, int> >& pairs) const;
+    // Pairs between the objects of node owner, whose spheres lie in [sliceMin, sliceMax], and the subtree at nodeIndex
+    void slicePairs(const View& view, uint32_t owner, const glm::vec3& sliceMin, const glm::vec3& sliceMax, uint32_t nodeIndex,
+                    std::vector<std::pair<int, int> >& pairs) const;
 };
+
+template <typename F>
+void Octree::query(const glm::vec3& min, const glm::vec3& max, F&& visit) const {
+    const View view = currentView();
+    ++view.counters->queries;
+    queryNode(view, 0, min, max, visit);
+}
+
+template <typename F>
+void Octree::queryNode(const View& view, uint32_t nodeIndex, const glm::vec3& min, const glm::vec3& max, F& visit) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    // Skip subtrees whose bounds miss the query box
+    const glm::vec3& nodeMin = node.boundsMin;
+    const glm::vec3& nodeMax = node.boundsMax;
+    if (!hasBounds(node) || nodeMax.x < min.x || nodeMin.x > max.x || nodeMax.y < min.y || nodeMin.y > max.y || nodeMax.z < min.z || nodeMin.z > max.z)
+        return;
+    view.counters->objectsTested += node.objectCount;
+    // Visit objects in this node
+    const uint32_t first = node.firstObject;
+    VisitContained(view.x + first, view.y + first, view.z + first, view.id + first, node.objectCount, min, max, visit);
+    // Query children
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) queryNode(view, node.firstChild + i, min, max, visit);
+    }
+}
+
+template <typename F>
+void Octree::queryFrustum(const Frustum& frustum, F&& visit) const {
+    const View view = currentView();
+    ++view.counters->queries;
+    queryFrustumNode(view, 0, frustum, visit);
+}
+
+template <typename F>
+void Octree::queryFrustumNode(const View& view, uint32_t nodeIndex, const Frustum& frustum, F& visit) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    // Every sphere stored at or below this node lies inside its bounds
+    if (!hasBounds(node))
+        return;
+    Frustum::Containment containment = frustum.classifyBox(node.boundsMin, node.boundsMax);
+    if (containment == Frustum::Outside)
+        return;
+    if (containment == Frustum::Inside) {
+        collectAll(view, nodeIndex, visit);
+        return;
+    }
+    view.counters->objectsTested += node.objectCount;
+    const uint32_t first = node.firstObject;
+    VisitInFrustum(view.x + first, view.y + first, view.z + first, view.radius + first,
+                   view.id + first, node.objectCount, frustum, visit);
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) queryFrustumNode(view, node.firstChild + i, frustum, visit);
+    }
+}
+
+template <typename F>
+void Octree::collectAll(const View& view, uint32_t nodeIndex, F& visit) const {
+    const Node& node = view.nodes[nodeIndex];
+    ++view.counters->nodesVisited;
+    VisitIds(view.id + node.firstObject, node.objectCount, visit);
+    for (int i = 0; i < 8; ++i) {
+        if (node.childMask & (1u << i)) collectAll(view, node.firstChild + i, visit);
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+#include "SpatialIndex.h"
+
+/***********************************************************
+ *  OctreeLeafScan
+ *
+ *  Tests over a node's packed object arrays, shared by the
+ *  Octree's vector queries and its inlined visitor queries.
+ *  Each hands the id of every object that passes to a
+ *  visitor called as visit(id).
+ ***********************************************************/
+
+// Visitor behind the vector queries, so they share the visitor traversal
+struct AppendToVector {
+    std::vector<int>& results;
+    void operator()(int id) { results.push_back(id); }
+};
+
+// Leaf tests use AVX2 when the compiler targets it (/arch:AVX2, -mavx2), SSE2 on
+// any x64 build or x86 with /arch:SSE2, and plain C++ otherwise. Define
+// OCTREE_NO_SIMD to force the scalar path.
+#if !defined(OCTREE_NO_SIMD) && defined(__AVX2__)
+#define OCTREE_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(OCTREE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define OCTREE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Visit every id of a node whose whole subtree passes; the overloads below copy
+// the run in one go instead of one call per id
+template <typename F>
+inline void VisitIds(const int* ids, uint32_t count, F& visit) {
+    for (uint32_t i = 0; i < count; ++i) visit(ids[i]);
+}
+
+inline void VisitIds(const int* ids, uint32_t count, AppendToVector& visit) {
+    visit.results.insert(visit.results.end(), ids, ids + count);
+}
+
+inline void VisitIds(const int* ids, uint32_t count, IdSpan& visit) {
+    if (visit.count < visit.capacity)
+        std::copy(ids, ids + std::min<size_t>(count, visit.capacity - visit.count), visit.data + visit.count);
+    visit.count += count;
+}
+
+#if defined(OCTREE_SIMD_AVX2) || defined(OCTREE_SIMD_SSE2)
+// Visit ids[lane] for every set bit of a movemask result
+template <typename F>
+inline void VisitMaskedIds(unsigned mask, const int* ids, F& visit) {
+    while (mask) {
+#if defined(_MSC_VER)
+        unsigned long lane;
+        _BitScanForward(&lane, mask);
+#else
+        unsigned lane = static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        visit(ids[lane]);
+        mask &= mask - 1;
+    }
+}
+#endif
+
+// Visit the ids of objects whose center lies inside [min, max]
+template <typename F>
+inline void VisitContained(const float* x, const float* y, const float* z, const int* ids, uint32_t count,
+                           const glm::vec3& min, const glm::vec3& max, F& visit) {
+    uint32_t i = 0;
+#if defined(OCTREE_SIMD_AVX2)
+    const __m256 minX = _mm256_set1_ps(min.x), minY = _mm256_set1_ps(min.y), minZ = _mm256_set1_ps(min.z);
+    const __m256 maxX = _mm256_set1_ps(max.x), maxY = _mm256_set1_ps(max.y), maxZ = _mm256_set1_ps(max.z);
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(px, minX, _CMP_GE_OQ), _mm256_cmp_ps(px, maxX, _CMP_LE_OQ));
+        inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(py, minY, _CMP_GE_OQ), _mm256_cmp_ps(py, maxY, _CMP_LE_OQ)));
+        inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(pz, minZ, _CMP_GE_OQ), _mm256_cmp_ps(pz, maxZ, _CMP_LE_OQ)));
+        VisitMaskedIds(static_cast<unsigned>(_mm256_movemask_ps(inside)), ids + i, visit);
+    }
+#elif defined(OCTREE_SIMD_SSE2)
+    const __m128 minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+    const __m128 maxX = _mm_set1_ps(max.x), maxY = _mm_set1_ps(max.y), maxZ = _mm_set1_ps(max.z);
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, minX), _mm_cmple_ps(px, maxX));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(py, minY), _mm_cmple_ps(py, maxY)));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(pz, minZ), _mm_cmple_ps(pz, maxZ)));
+        VisitMaskedIds(static_cast<unsigned>(_mm_movemask_ps(inside)), ids + i, visit);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (x[i] >= min.x && x[i] <= max.x && y[i] >= min.y && y[i] <= max.y && z[i] >= min.z && z[i] <= max.z)
+            visit(ids[i]);
+    }
+}
+
+// Visit the ids of objects whose sphere is not entirely behind any frustum plane
+// (same test and evaluation order as Frustum::intersectsSphere)
+template <typename F>
+inline void VisitInFrustum(const float* x, const float* y, const float* z, const float* radius, const int* ids, uint32_t count,
+                           const Frustum& frustum, F& visit) {
+    uint32_t i = 0;
+#if defined(OCTREE_SIMD_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const glm::vec4& plane : frustum.planes) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(px, _mm256_set1_ps(plane.x)), _mm256_mul_ps(py, _mm256_set1_ps(plane.y))),
+                _mm256_mul_ps(pz, _mm256_set1_ps(plane.z))), _mm256_set1_ps(plane.w));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_NLT_UQ));
+        }
+        VisitMaskedIds(static_cast<unsigned>(_mm256_movemask_ps(inside)), ids + i, visit);
+    }
+#elif defined(OCTREE_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4& plane : frustum.planes) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(px, _mm_set1_ps(plane.x)), _mm_mul_ps(py, _mm_set1_ps(plane.y))),
+                _mm_mul_ps(pz, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+            inside = _mm_and_ps(inside, _mm_cmpnlt_ps(dist, negRadius));
+        }
+        VisitMaskedIds(static_cast<unsigned>(_mm_movemask_ps(inside)), ids + i, visit);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (frustum.intersectsSphere(glm::vec3(x[i], y[i], z[i]), radius[i]))
+            visit(ids[i]);
+    }
+}
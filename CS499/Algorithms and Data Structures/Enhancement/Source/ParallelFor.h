@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ParallelFor
+ *
+ *  Minimal fork-join helpers built on std::thread. The
+ *  calling thread takes part in the work, and every index
+ *  is handled exactly once, so results written per index or
+ *  per slice do not depend on scheduling.
+ ***********************************************************/
+
+// Threads to use for a requested count (0 or less = all hardware threads)
+inline int ResolveThreadCount(int requested)
+{
+    if (requested > 0)
+        return requested;
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+// Calls body(slice, begin, end) for threadCount contiguous slices of [0, count)
+template <typename Body>
+void ParallelForSlices(size_t count, int threadCount, const Body& body)
+{
+    size_t slices = static_cast<size_t>(std::max(threadCount, 1));
+    if (slices > count) slices = count > 0 ? count : 1;
+
+    std::vector<std::thread> workers;
+    workers.reserve(slices - 1);
+    for (size_t s = 1; s < slices; ++s)
+    {
+        workers.emplace_back([&body, s, slices, count]() {
+            body(s, count * s / slices, count * (s + 1) / slices);
+        });
+    }
+    body(0, 0, count / slices);
+    for (auto& worker : workers) worker.join();
+}
+
+// Calls body(i) for every i in [0, count), handing out indices dynamically
+template <typename Body>
+void ParallelForEach(size_t count, int threadCount, const Body& body)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&body, &next, count]() {
+        for (size_t i = next++; i < count; i = next++)
+            body(i);
+    };
+
+    size_t helpers = std::min(static_cast<size_t>(std::max(threadCount, 1)), count);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < helpers; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+}
+
+/***********************************************************
+ *  WorkerPool
+ *
+ *  Threads that stay parked between jobs, for callers that
+ *  fork and join many times per frame, where starting fresh
+ *  threads each time would cost more than the work. Slices
+ *  are the same as ParallelForSlices, so results match it.
+ ***********************************************************/
+class WorkerPool
+{
+public:
+    // threadCount - 1 workers; the calling thread is the last one
+    explicit WorkerPool(int threadCount)
+        : m_invoke(nullptr), m_body(nullptr), m_count(0), m_slices(0), m_nextSlice(0),
+          m_busy(0), m_generation(0), m_stop(false)
+    {
+        for (int t = 1; t < std::max(threadCount, 1); ++t)
+            m_workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers) worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // Calls body(slice, begin, end) for `slices` contiguous slices of [0, count), at most
+    // threadCount() at a time, and returns once every slice is done
+    template <typename Body>
+    void forSlices(size_t count, int slices, const Body& body)
+    {
+        size_t sliceCount = static_cast<size_t>(std::max(slices, 1));
+        if (sliceCount > count) sliceCount = count > 0 ? count : 1;
+        if (sliceCount == 1 || m_workers.empty())
+        {
+            for (size_t s = 0; s < sliceCount; ++s)
+                body(s, count * s / sliceCount, count * (s + 1) / sliceCount);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_invoke = [](const void* target, size_t slice, size_t begin, size_t end) {
+                (*static_cast<const Body*>(target))(slice, begin, end);
+            };
+            m_body = &body;
+            m_count = count;
+            m_slices = sliceCount;
+            m_nextSlice.store(0);
+            m_busy = m_workers.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        runSlices();
+
+        // Workers read the job fields, so the next job waits until all have left this one
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+    }
+
+private:
+    typedef void (*Invoke)(const void* body, size_t slice, size_t begin, size_t end);
+
+    void runSlices()
+    {
+        for (size_t s = m_nextSlice++; s < m_slices; s = m_nextSlice++)
+            m_invoke(m_body, s, m_count * s / m_slices, m_count * (s + 1) / m_slices);
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, seen]() { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+            }
+            runSlices();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    Invoke m_invoke;                  // Current job, written under m_mutex before waking workers
+    const void* m_body;
+    size_t m_count;
+    size_t m_slices;
+    std::atomic<size_t> m_nextSlice;
+    size_t m_busy;                    // Workers that have not finished the current job
+    uint64_t m_generation;            // Bumped for every job
+    bool m_stop;
+};
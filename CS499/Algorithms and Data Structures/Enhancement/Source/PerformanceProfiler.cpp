@@ -62,6 +62,20 @@ void PerformanceProfiler::recordVisibleObjects(int count)
     m_visibleObjects = count;
 }
 
+void PerformanceProfiler::recordIndexMetric(const std::string& name, double value)
+{
+    // A handful of entries, so a linear search keeps the logging order stable
+    for (auto& metric : m_indexMetrics)
+    {
+        if (metric.first == name)
+        {
+            metric.second = value;
+            return;
+        }
+    }
+    m_indexMetrics.push_back(std::make_pair(name, value));
+}
+
 void PerformanceProfiler::startSection(const std::string& name)
 {
     m_sections[name].start = std::chrono::high_resolution_clock::now();
@@ -95,6 +109,13 @@ void PerformanceProfiler::logToFile(const std::string& filename)
         file << "Average Frame Time: " << (m_totalFrameTime / m_totalFrames) << " ms\n";
         file << "Average FPS: " << (1000.0 / (m_totalFrameTime / m_totalFrames)) << "\n";
     }
+
+    if (!m_indexMetrics.empty())
+    {
+        file << "\nSpatial Index:\n";
+        for (const auto& metric : m_indexMetrics)
+            file << "  " << metric.first << ": " << metric.second << "\n";
+    }
     
     file << "\nSection Timings:\n";
     for (const auto& pair : m_sections)
@@ -126,6 +147,8 @@ void PerformanceProfiler::logToConsole()
         std::cout << "Average Frame Time: " << (m_totalFrameTime / m_totalFrames) << " ms\n";
         std::cout << "Average FPS: " << (1000.0 / (m_totalFrameTime / m_totalFrames)) << "\n";
     }
+    for (const auto& metric : m_indexMetrics)
+        std::cout << metric.first << ": " << metric.second << "\n";
     std::cout << "========================\n\n";
 }
 
@@ -135,4 +158,5 @@ void PerformanceProfiler::reset()
     m_totalFrames = 0;
     m_frameCount = 0;
     m_sections.clear();
+    m_indexMetrics.clear();
 }
@@ -2,6 +2,8 @@
 #include <chrono>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <fstream>
 
 /***********************************************************
@@ -23,6 +25,10 @@ public:
     void recordObjectCount(int count);
     void recordDrawCall();
     void recordVisibleObjects(int count);
+    // Named value reported under "Spatial Index" by logToFile and logToConsole, such as
+    // node counts or nodes visited per query. Recording a name again overwrites it;
+    // names are logged in the order they were first recorded.
+    void recordIndexMetric(const std::string& name, double value);
     
     // Profiling sections
     void startSection(const std::string& name);
@@ -61,6 +67,7 @@ private:
     int m_frameCount;
     
     std::unordered_map<std::string, SectionTimer> m_sections;
+    std::vector<std::pair<std::string, double> > m_indexMetrics;
     
     double m_totalFrameTime;
     int m_totalFrames;
@@ -15,6 +15,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "Octree.h"
+#include "ConcurrentOctree.h"
+#include "BVH.h"
+#include "SpatialHashGrid.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -23,6 +27,8 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <map>
 
 // Global shader uniform names - must match shader variable names exactly
 namespace
@@ -32,6 +38,15 @@ namespace
 	const char* g_TextureValueName = "objectTexture"; // Texture sampler uniform  
 	const char* g_UseTextureName = "bUseTexture"; // Boolean for texture usage
 	const char* g_UseLightingName = "bUseLighting"; // Boolean for lighting toggle
+
+	// Translation and rotation of a render object, without its scale
+	glm::mat4 PlacementOf(const SceneManager::RENDER_OBJECT& obj)
+	{
+		glm::mat4 rotX = glm::rotate(glm::radians(obj.xrot), glm::vec3(1, 0, 0));
+		glm::mat4 rotY = glm::rotate(glm::radians(obj.yrot), glm::vec3(0, 1, 0));
+		glm::mat4 rotZ = glm::rotate(glm::radians(obj.zrot), glm::vec3(0, 0, 1));
+		return glm::translate(obj.pos) * rotX * rotY * rotZ;
+	}
 }
 
 /***********************************************************
@@ -57,63 +72,34 @@ void SceneManager::RenderScene()
     profiler.startFrame();
     profiler.startSection("Frustum Culling");
     
-    // Camera frustum region (for demo: a bounding box around origin)
-    glm::vec3 frustumMin(-8.0f, -2.0f, -8.0f);
-    glm::vec3 frustumMax(8.0f, 8.0f, 8.0f);
-    std::vector<int> visibleObjectIds;
-    QueryObjectsInRegion(frustumMin, frustumMax, visibleObjectIds);
+    // Camera frustum from the current view/projection (see SetViewProjection). With a
+    // worker started by BeginCulling, this section is only the wait for it.
+    CullSceneObjects();
+    profiler.recordIndexMetric("Culling nodes visited", static_cast<double>(m_lastCullCounters.nodesVisited));
+    profiler.recordIndexMetric("Culling objects tested", static_cast<double>(m_lastCullCounters.objectsTested));
     
     profiler.endSection("Frustum Culling");
     profiler.startSection("Object Rendering");
 
-    // Object definitions (id, position, bounding radius, mesh type)
-    struct RenderObj {
-        int id;
-        glm::vec3 pos;
-        glm::vec3 scale;
-        float xrot, yrot, zrot;
-        std::string texture;
-        std::string material;
-        std::string meshType;
-        float boundingRadius;
-    };
-    std::vector<RenderObj> objects = {
-        {1, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(12.0f, 1.0f, 7.0f), 0, 0, 0, "desk_wood", "wood", "plane", 7.0f},
-        {2, glm::vec3(0.0f, 0.06f, 0.8f), glm::vec3(2.8f, 0.12f, 2.0f), 0, 0, 0, "laptop_base", "metal", "box", 1.5f},
-        {3, glm::vec3(0.0f, 1.0f, 0.2f), glm::vec3(3.0f, 1.8f, 0.08f), -20, 0, 0, "laptop_screen", "screen", "box", 1.8f},
-        {4, glm::vec3(-2.2f, 0.35f, 1.5f), glm::vec3(0.5f, 0.7f, 0.5f), 0, 0, 0, "mug_ceramic", "ceramic", "cylinder", 0.7f},
-        {5, glm::vec3(-1.7f, 0.35f, 1.5f), glm::vec3(0.4f, 0.4f, 0.4f), 0, 90, 0, "mug_ceramic", "ceramic", "halftorus", 0.4f},
-        {6, glm::vec3(3.5f, 0.125f, -0.5f), glm::vec3(1.0f, 0.25f, 1.5f), 0, 0, 0, "book_cover", "paper", "box", 1.0f},
-        {7, glm::vec3(3.5f, 0.365f, -0.5f), glm::vec3(0.95f, 0.23f, 1.45f), 0, 3, 0, "book_spine", "wood", "box", 1.0f},
-        {8, glm::vec3(3.5f, 0.575f, -0.5f), glm::vec3(0.9f, 0.2f, 1.4f), 0, -5, 0, "book_cover", "paper", "box", 1.0f},
-        {9, glm::vec3(-3.5f, 0.075f, -2.0f), glm::vec3(0.7f, 0.15f, 0.7f), 0, 0, 0, "lamp_metal", "metal", "cylinder", 0.7f},
-        {10, glm::vec3(-2.8f, 1.1f, -2.0f), glm::vec3(0.12f, 2.0f, 0.12f), 0, 0, 30, "lamp_metal", "metal", "cylinder", 2.0f},
-        {11, glm::vec3(-2.2f, 2.0f, -2.0f), glm::vec3(0.8f, 0.6f, 0.8f), 180, 0, 30, "lamp_metal", "metal", "cone", 0.8f},
-        {12, glm::vec3(-4.5f, 0.25f, -0.8f), glm::vec3(0.6f, 0.5f, 0.6f), 0, 0, 0, "plant_pot", "ceramic", "cylinder", 0.6f},
-        {13, glm::vec3(-4.5f, 0.65f, -0.8f), glm::vec3(0.5f, 0.4f, 0.5f), 0, 0, 0, "plant_foliage", "fabric", "sphere", 0.5f}
-    };
-
     // Record metrics
-    profiler.recordObjectCount(static_cast<int>(objects.size()));
-    profiler.recordVisibleObjects(static_cast<int>(visibleObjectIds.size()));
-
-    // Register objects in octree (step 1)
-    for (const auto& obj : objects) {
-        SceneObject so{obj.pos, obj.boundingRadius, obj.id};
-        RegisterSceneObject(so);
-    }
-
-    // Render only visible objects (step 2)
-    for (const auto& obj : objects) {
-        if (std::find(visibleObjectIds.begin(), visibleObjectIds.end(), obj.id) == visibleObjectIds.end()) continue;
-
-        // Math optimization: cache transformation matrix
-        glm::mat4 scale = glm::scale(obj.scale);
-        glm::mat4 rotX = glm::rotate(glm::radians(obj.xrot), glm::vec3(1,0,0));
-        glm::mat4 rotY = glm::rotate(glm::radians(obj.yrot), glm::vec3(0,1,0));
-        glm::mat4 rotZ = glm::rotate(glm::radians(obj.zrot), glm::vec3(0,0,1));
-        glm::mat4 trans = glm::translate(obj.pos);
-        glm::mat4 modelView = trans * rotX * rotY * rotZ * scale;
+    profiler.recordObjectCount(static_cast<int>(m_renderObjects.size()));
+    profiler.recordVisibleObjects(static_cast<int>(m_visibleObjectIds.size()));
+
+    // Objects were registered once in PrepareScene, so the index is
+    // only read here. Sorting lets the draw loop keep its stable order.
+    // An object handed to the hash grid this frame is still in the
+    // snapshot the worker culled, so it can come back twice.
+    std::sort(m_visibleObjectIds.begin(), m_visibleObjectIds.end());
+    m_visibleObjectIds.erase(std::unique(m_visibleObjectIds.begin(), m_visibleObjectIds.end()), m_visibleObjectIds.end());
+
+    // Render only visible objects
+    for (const auto& obj : m_renderObjects) {
+        if (!std::binary_search(m_visibleObjectIds.begin(), m_visibleObjectIds.end(), obj.id)) continue;
+
+        // Math optimization: cache transformation matrix. Scene graph objects take their
+        // placement from the node, so moving a parent carries its children along
+        glm::mat4 placement = obj.node ? obj.node->getWorldTransform() : PlacementOf(obj);
+        glm::mat4 modelView = placement * glm::scale(obj.scale);
         if (m_pShaderManager) m_pShaderManager->setMat4Value("model", modelView);
 
         // Set texture/material
@@ -121,7 +107,7 @@ void SceneManager::RenderScene()
         SetShaderMaterial(obj.material);
 
         // LOD logic (step 3): use low detail for distant objects
-        float camDist = glm::length(obj.pos); // For demo, camera at origin
+        float camDist = glm::length(glm::vec3(placement[3])); // For demo, camera at origin
         bool useLowLOD = camDist > 6.0f;
 
         profiler.recordDrawCall();
@@ -151,11 +137,24 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
 
-    // Octree covers workspace, adjust size as needed
-    m_octree = new Octree(glm::vec3(0.0f, 0.0f, 0.0f), 10.0f, 0, 5);
+    // Loose octree starts around the workspace and grows its root when an
+    // object lands outside it; large objects such as the desk plane stay
+    // near the root instead of a tiny leaf. Readers cull a published copy,
+    // so culling can run on a worker while the main thread edits. DefineSceneObjects
+    // swaps it for a BVH when SetStaticIndexKind asks for one. Moving objects go to the grid.
+    m_spatialIndex = new ConcurrentOctree(glm::vec3(0.0f, 0.0f, 0.0f), 10.0f, 5, 2.0f);
+    m_staticIndexKind = StaticIndexKind::Octree;
+    m_lastCullCounters = OctreeQueryCounters();
+    m_cullCounters = OctreeQueryCounters();
+    m_dynamicIndex = new SpatialHashGrid();
+    m_sceneRegistry = new SceneRegistry(m_spatialIndex, m_dynamicIndex);
     
     // Initialize scene graph
     m_sceneRoot = std::make_shared<SceneNode>("root");
+    m_sceneGraph = new FlatSceneGraph(m_sceneRoot);
+    m_sceneGraphThreads = 1;
+    m_sceneGraphNodesUpdated = 0;
+    m_sceneGraphUpdates = 0;
 }
 
 /***********************************************************
@@ -169,69 +168,341 @@ SceneManager::~SceneManager()
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
 
-    delete m_octree;
-    m_octree = nullptr;
+    WaitForCulling();
+    delete m_sceneRegistry;
+    m_sceneRegistry = nullptr;
+    delete m_spatialIndex;
+    m_spatialIndex = nullptr;
+    delete m_dynamicIndex;
+    m_dynamicIndex = nullptr;
+    delete m_sceneGraph;
+    m_sceneGraph = nullptr;
 }
 
-// Register a scene object in the octree
-void SceneManager::RegisterSceneObject(const SceneObject& obj)
+// Register a scene object in the spatial index
+void SceneManager::RegisterSceneObject(const SceneObject& obj, bool dynamic)
+{
+    if (m_sceneRegistry) m_sceneRegistry->registerObject(obj, dynamic);
+}
+
+// Re-index a scene object whose transform may have changed
+void SceneManager::UpdateSceneObject(const SceneObject& obj)
+{
+    if (m_sceneRegistry) m_sceneRegistry->updateObject(obj);
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  Defines the render list for the desk scene and registers
+ *  every object in the static index chosen by
+ *  SetStaticIndexKind with a single bulk build. The hash grid for
+ *  moving objects starts empty with cells sized to the scene.
+ *  Called once from PrepareScene; RenderScene only queries
+ *  the indexes afterwards.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
 {
-    if (m_octree) m_octree->insert(obj);
+    // Object definitions (id, position, scale, rotation, texture, material, mesh type, bounding radius)
+    m_renderObjects = {
+        {1, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(12.0f, 1.0f, 7.0f), 0, 0, 0, "desk_wood", "wood", "plane", 7.0f},
+        {2, glm::vec3(0.0f, 0.06f, 0.8f), glm::vec3(2.8f, 0.12f, 2.0f), 0, 0, 0, "laptop_base", "metal", "box", 1.5f},
+        {3, glm::vec3(0.0f, 1.0f, 0.2f), glm::vec3(3.0f, 1.8f, 0.08f), -20, 0, 0, "laptop_screen", "screen", "box", 1.8f},
+        {4, glm::vec3(-2.2f, 0.35f, 1.5f), glm::vec3(0.5f, 0.7f, 0.5f), 0, 0, 0, "mug_ceramic", "ceramic", "cylinder", 0.7f},
+        {5, glm::vec3(-1.7f, 0.35f, 1.5f), glm::vec3(0.4f, 0.4f, 0.4f), 0, 90, 0, "mug_ceramic", "ceramic", "halftorus", 0.4f},
+        {6, glm::vec3(3.5f, 0.125f, -0.5f), glm::vec3(1.0f, 0.25f, 1.5f), 0, 0, 0, "book_cover", "paper", "box", 1.0f},
+        {7, glm::vec3(3.5f, 0.365f, -0.5f), glm::vec3(0.95f, 0.23f, 1.45f), 0, 3, 0, "book_spine", "wood", "box", 1.0f},
+        {8, glm::vec3(3.5f, 0.575f, -0.5f), glm::vec3(0.9f, 0.2f, 1.4f), 0, -5, 0, "book_cover", "paper", "box", 1.0f},
+        {9, glm::vec3(-3.5f, 0.075f, -2.0f), glm::vec3(0.7f, 0.15f, 0.7f), 0, 0, 0, "lamp_metal", "metal", "cylinder", 0.7f},
+        {10, glm::vec3(-2.8f, 1.1f, -2.0f), glm::vec3(0.12f, 2.0f, 0.12f), 0, 0, 30, "lamp_metal", "metal", "cylinder", 2.0f},
+        {11, glm::vec3(-2.2f, 2.0f, -2.0f), glm::vec3(0.8f, 0.6f, 0.8f), 180, 0, 30, "lamp_metal", "metal", "cone", 0.8f},
+        {12, glm::vec3(-4.5f, 0.25f, -0.8f), glm::vec3(0.6f, 0.5f, 0.6f), 0, 0, 0, "plant_pot", "ceramic", "cylinder", 0.6f},
+        {13, glm::vec3(-4.5f, 0.65f, -0.8f), glm::vec3(0.5f, 0.4f, 0.5f), 0, 0, 0, "plant_foliage", "fabric", "sphere", 0.5f}
+    };
+
+    // Lamp and plant parts are placed by the scene graph from here on
+    BuildSceneGraph();
+
+    std::vector<SceneObject> sceneObjects;
+    for (const auto& obj : m_renderObjects) {
+        sceneObjects.push_back(SceneObject{obj.pos, obj.boundingRadius, obj.id});
+    }
+
+    // Fixed by the setting rather than timed here, so every run indexes the scene the
+    // same way; RunIndexComparisonBenchmark measures which kind suits a scene
+    WaitForCulling();
+    delete m_sceneRegistry;
+    delete m_spatialIndex;
+    delete m_dynamicIndex;
+    if (m_staticIndexKind == StaticIndexKind::BVH)
+        m_spatialIndex = new BVH();
+    else
+        m_spatialIndex = new ConcurrentOctree(glm::vec3(0.0f, 0.0f, 0.0f), 10.0f, 5, 2.0f);
+    m_dynamicIndex = new SpatialHashGrid(SpatialHashGrid::cellSizeFor(sceneObjects));
+    m_sceneRegistry = new SceneRegistry(m_spatialIndex, m_dynamicIndex);
+    m_sceneRegistry->registerObjects(sceneObjects);
+    PublishSceneChanges();
+    m_visibleObjectIds.reserve(m_renderObjects.size());
+    // The old cache describes the index just deleted
+    m_cullCache = Octree::CullCache();
+    m_visibleStaticIds.clear();
+    std::cout << "INFO: Using " << m_spatialIndex->name() << " spatial index for " << sceneObjects.size() << " objects" << std::endl;
 }
 
 // Query objects in a region (for frustum culling, etc.)
 void SceneManager::QueryObjectsInRegion(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const
 {
-    if (m_octree) m_octree->query(min, max, results);
+    if (m_spatialIndex) m_spatialIndex->query(min, max, results);
+    if (m_dynamicIndex) m_dynamicIndex->query(min, max, results);
+}
+
+// Query objects visible in the camera frustum
+void SceneManager::QueryObjectsInFrustum(const Frustum& frustum, std::vector<int>& results) const
+{
+    if (m_spatialIndex) m_spatialIndex->queryFrustum(frustum, results);
+    if (m_dynamicIndex) m_dynamicIndex->queryFrustum(frustum, results);
+}
+
+// Cull for the current frustum into m_visibleObjectIds. With an Octree only the static
+// objects whose visibility changed since the last frame come back, and the sorted
+// visible list is patched with them instead of being rebuilt; that part normally ran
+// on the worker started by BeginCulling. The dynamic objects are few and move every
+// frame, so the hash grid is queried in full here, after this frame's moves.
+void SceneManager::CullSceneObjects()
+{
+    m_visibleObjectIds.clear();
+    if (m_cullWorker.joinable())
+    {
+        WaitForCulling();
+    }
+    else if (const ConcurrentOctree* octree = dynamic_cast<const ConcurrentOctree*>(m_spatialIndex))
+    {
+        // BeginCulling was not called this frame
+        CullStaticObjects(*octree->snapshot(), m_frustum);
+    }
+    else
+    {
+        m_lastCullCounters = OctreeQueryCounters();
+        QueryObjectsInFrustum(m_frustum, m_visibleObjectIds);
+        return;
+    }
+
+    m_visibleObjectIds.assign(m_visibleStaticIds.begin(), m_visibleStaticIds.end());
+    if (m_dynamicIndex) m_dynamicIndex->queryFrustum(m_frustum, m_visibleObjectIds);
+}
+
+void SceneManager::CullStaticObjects(const Octree& octree, const Frustum& frustum)
+{
+    const OctreeQueryCounters before = Octree::queryCounters();
+    m_becameVisible.clear();
+    m_becameHidden.clear();
+    octree.queryFrustumChanges(frustum, m_cullCache, m_becameVisible, m_becameHidden);
+    if (!m_becameHidden.empty())
+    {
+        std::sort(m_becameHidden.begin(), m_becameHidden.end());
+        m_visibleStaticIds.erase(std::remove_if(m_visibleStaticIds.begin(), m_visibleStaticIds.end(),
+            [this](int id) { return std::binary_search(m_becameHidden.begin(), m_becameHidden.end(), id); }),
+            m_visibleStaticIds.end());
+    }
+    if (!m_becameVisible.empty())
+    {
+        std::sort(m_becameVisible.begin(), m_becameVisible.end());
+        size_t middle = m_visibleStaticIds.size();
+        m_visibleStaticIds.insert(m_visibleStaticIds.end(), m_becameVisible.begin(), m_becameVisible.end());
+        std::inplace_merge(m_visibleStaticIds.begin(), m_visibleStaticIds.begin() + middle, m_visibleStaticIds.end());
+    }
+
+    const OctreeQueryCounters& after = Octree::queryCounters();
+    m_lastCullCounters.queries = after.queries - before.queries;
+    m_lastCullCounters.nodesVisited = after.nodesVisited - before.nodesVisited;
+    m_lastCullCounters.objectsTested = after.objectsTested - before.objectsTested;
+    m_cullCounters.queries += m_lastCullCounters.queries;
+    m_cullCounters.nodesVisited += m_lastCullCounters.nodesVisited;
+    m_cullCounters.objectsTested += m_lastCullCounters.objectsTested;
+}
+
+void SceneManager::BeginCulling()
+{
+    WaitForCulling();
+    const ConcurrentOctree* octree = dynamic_cast<const ConcurrentOctree*>(m_spatialIndex);
+    if (!octree)
+        return;
+
+    // The worker keeps the snapshot alive, so the main thread may edit and even
+    // publish meanwhile; the frustum is copied for the same reason
+    std::shared_ptr<const Octree> snapshot = octree->snapshot();
+    const Frustum frustum = m_frustum;
+    m_cullWorker = std::thread([this, snapshot, frustum]() { CullStaticObjects(*snapshot, frustum); });
+}
+
+void SceneManager::WaitForCulling()
+{
+    if (m_cullWorker.joinable())
+        m_cullWorker.join();
+}
+
+void SceneManager::PublishSceneChanges()
+{
+    if (ConcurrentOctree* octree = dynamic_cast<ConcurrentOctree*>(m_spatialIndex))
+        octree->publish();
+}
+
+void SceneManager::RecordSpatialIndexStats() const
+{
+    // The flat pass replaces the recursive SceneNode::update; report its work in the log
+    auto& profiler = PerformanceProfiler::getInstance();
+    if (m_sceneGraph)
+    {
+        profiler.recordIndexMetric("Scene graph nodes", static_cast<double>(m_sceneGraph->size()));
+        profiler.recordIndexMetric("Scene graph levels", static_cast<double>(m_sceneGraph->levelCount()));
+        if (m_sceneGraphUpdates > 0)
+            profiler.recordIndexMetric("Scene graph nodes updated per frame",
+                static_cast<double>(m_sceneGraphNodesUpdated) / m_sceneGraphUpdates);
+    }
+
+    const ConcurrentOctree* concurrent = dynamic_cast<const ConcurrentOctree*>(m_spatialIndex);
+    if (!concurrent)
+        return;
+
+    // The published tree; the loop publishes before it records stats, so it is current
+    std::shared_ptr<const Octree> octree = concurrent->snapshot();
+    const OctreeStats stats = octree->computeStats();
+    profiler.recordIndexMetric("Octree nodes", static_cast<double>(stats.nodeCount));
+    profiler.recordIndexMetric("Octree leaves", static_cast<double>(stats.leafCount));
+    profiler.recordIndexMetric("Octree empty nodes", static_cast<double>(stats.emptyNodeCount));
+    profiler.recordIndexMetric("Octree empty leaves", static_cast<double>(stats.emptyLeafCount));
+    profiler.recordIndexMetric("Octree objects per leaf (avg)", stats.averageObjectsPerLeaf);
+    profiler.recordIndexMetric("Octree objects per leaf (max)", static_cast<double>(stats.maxObjectsPerLeaf));
+    for (size_t depth = 0; depth < stats.nodesPerDepth.size(); ++depth)
+    {
+        profiler.recordIndexMetric("Octree nodes at depth " + std::to_string(depth), static_cast<double>(stats.nodesPerDepth[depth]));
+        profiler.recordIndexMetric("Octree objects at depth " + std::to_string(depth), static_cast<double>(stats.objectsPerDepth[depth]));
+    }
+    profiler.recordIndexMetric("Octree bytes", static_cast<double>(stats.bytesUsed));
+
+    // Picking runs on this thread, culling on the worker
+    OctreeQueryCounters counters = Octree::queryCounters();
+    counters.queries += m_cullCounters.queries;
+    counters.nodesVisited += m_cullCounters.nodesVisited;
+    if (counters.queries > 0)
+        profiler.recordIndexMetric("Octree nodes visited per query", static_cast<double>(counters.nodesVisited) / counters.queries);
+}
+
+// Rebuild the culling frustum from the camera matrices
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+    m_frustum = Frustum::fromMatrices(view, projection);
+}
+
+// Nearest object under a picking ray (see ViewManager::ConsumePickRay)
+int SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction) const
+{
+    RayHit hit;
+    int picked = -1;
+    float nearest = std::numeric_limits<float>::max();
+    if (m_spatialIndex && m_spatialIndex->raycastFirst(origin, direction, hit, nearest))
+    {
+        picked = hit.id;
+        nearest = hit.distance;
+    }
+    if (m_dynamicIndex && m_dynamicIndex->raycastFirst(origin, direction, hit, nearest) && hit.distance < nearest)
+        picked = hit.id;
+    return picked;
 }
 
-// Build scene graph with hierarchical relationships
+// Build scene graph with hierarchical relationships. Nodes carry placement only
+// (translation and rotation); each object's scale is applied when it is drawn, so a
+// parent's scale never stretches its children. Locals are derived from the placements
+// in m_renderObjects, so the hierarchy reproduces the existing layout.
 void SceneManager::BuildSceneGraph()
 {
-    // Example: Create lamp hierarchy (base -> neck -> shade)
-    auto lampBase = std::make_shared<SceneNode>("lamp_base");
-    lampBase->setPosition(glm::vec3(-3.5f, 0.075f, -2.0f));
-    lampBase->setScale(glm::vec3(0.7f, 0.15f, 0.7f));
-    lampBase->objectId = 9;
-    
-    auto lampNeck = std::make_shared<SceneNode>("lamp_neck");
-    lampNeck->setPosition(glm::vec3(0.7f, 1.025f, 0.0f)); // Relative to base
-    lampNeck->setScale(glm::vec3(0.12f, 2.0f, 0.12f));
-    lampNeck->setRotation(glm::vec3(0.0f, 0.0f, 30.0f));
-    lampNeck->objectId = 10;
-    
-    auto lampShade = std::make_shared<SceneNode>("lamp_shade");
-    lampShade->setPosition(glm::vec3(0.6f, 0.9f, 0.0f)); // Relative to neck
-    lampShade->setScale(glm::vec3(0.8f, 0.6f, 0.8f));
-    lampShade->setRotation(glm::vec3(180.0f, 0.0f, 30.0f));
-    lampShade->objectId = 11;
-    
-    // Build hierarchy
-    lampBase->addChild(lampNeck);
-    lampNeck->addChild(lampShade);
-    m_sceneRoot->addChild(lampBase);
-    
-    // Example: Create plant hierarchy (pot -> foliage)
-    auto plantPot = std::make_shared<SceneNode>("plant_pot");
-    plantPot->setPosition(glm::vec3(-4.5f, 0.25f, -0.8f));
-    plantPot->setScale(glm::vec3(0.6f, 0.5f, 0.6f));
-    plantPot->objectId = 12;
-    
-    auto plantFoliage = std::make_shared<SceneNode>("plant_foliage");
-    plantFoliage->setPosition(glm::vec3(0.0f, 0.4f, 0.0f)); // Relative to pot
-    plantFoliage->setScale(glm::vec3(0.5f, 0.4f, 0.5f));
-    plantFoliage->objectId = 13;
-    
-    plantPot->addChild(plantFoliage);
-    m_sceneRoot->addChild(plantPot);
+    // Lamp: base -> neck -> shade. Plant: pot -> foliage. Parents are listed first.
+    struct Link
+    {
+        const char* name;
+        int objectId;
+        int parentId;
+    };
+    const Link links[] = {
+        { "lamp_base", 9, -1 }, { "lamp_neck", 10, 9 }, { "lamp_shade", 11, 10 },
+        { "plant_pot", 12, -1 }, { "plant_foliage", 13, 12 }
+    };
+
+    // Start from an empty graph, so defining the scene again does not duplicate nodes
+    delete m_sceneGraph;
+    m_sceneRoot = std::make_shared<SceneNode>("root");
+    m_sceneGraph = new FlatSceneGraph(m_sceneRoot);
+
+    std::map<int, std::shared_ptr<SceneNode>> nodes;
+    std::map<int, glm::mat4> placements;
+    for (const Link& link : links)
+    {
+        auto obj = std::find_if(m_renderObjects.begin(), m_renderObjects.end(),
+            [&link](const RENDER_OBJECT& candidate) { return candidate.id == link.objectId; });
+        if (obj == m_renderObjects.end())
+            continue;
+
+        auto node = std::make_shared<SceneNode>(link.name);
+        node->objectId = link.objectId;
+        glm::mat4 placement = PlacementOf(*obj);
+        auto parent = nodes.find(link.parentId);
+        if (parent != nodes.end())
+        {
+            node->setLocalTransform(glm::inverse(placements[link.parentId]) * placement);
+            parent->second->addChild(node);
+        }
+        else
+        {
+            node->setLocalTransform(placement);
+            m_sceneRoot->addChild(node);
+        }
+        obj->node = node.get();
+        nodes[link.objectId] = node;
+        placements[link.objectId] = placement;
+    }
+
+    // First pass now, so the positions indexed next already come from the graph and
+    // the first UpdateSceneGraph finds nothing to move
+    m_sceneGraph->update();
+    for (auto& obj : m_renderObjects)
+    {
+        if (obj.node)
+            obj.pos = glm::vec3(obj.node->getWorldTransform()[3]);
+    }
 }
 
 // Update scene graph transformations
 void SceneManager::UpdateSceneGraph()
 {
-    if (m_sceneRoot)
+    if (m_sceneGraph)
     {
-        m_sceneRoot->update();
+        // Returns at once when nothing was marked dirty, so a static hierarchy costs nothing
+        // per frame; otherwise one linear pass recomputes the moved nodes and their descendants
+        m_changedNodes.clear();
+        m_sceneGraph->update(glm::mat4(1.0f), &m_changedNodes, m_sceneGraphThreads);
+        for (const SceneNode* node : m_changedNodes)
+        {
+            SyncSceneNodeToIndex(*node);
+        }
+
+        // Reported by RecordSpatialIndexStats
+        m_sceneGraphNodesUpdated += m_changedNodes.size();
+        ++m_sceneGraphUpdates;
+    }
+}
+
+// Moved nodes feed their new world position to the index; the registry hands a static
+// object over to the dynamic index the first time its position actually changes
+void SceneManager::SyncSceneNodeToIndex(const SceneNode& node)
+{
+    if (node.objectId >= 0 && m_sceneRegistry)
+    {
+        const SceneObject* indexed = m_sceneRegistry->find(node.objectId);
+        if (indexed)
+        {
+            glm::vec3 worldPosition(node.getWorldTransform()[3]);
+            m_sceneRegistry->updateObject(SceneObject{ worldPosition, indexed->boundingRadius, node.objectId });
+        }
     }
 }
 
@@ -819,4 +1090,7 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadConeMesh();     // ? CONE - For lamp shade
 	m_basicMeshes->LoadTorusMesh(0.1f); // ? TORUS - For coffee mug handle
 	m_basicMeshes->LoadSphereMesh();   // ? SPHERE - For plant foliage
+
+	// Register scene objects in the spatial index once; RenderScene only queries it
+	DefineSceneObjects();
 }
\ No newline at end of file
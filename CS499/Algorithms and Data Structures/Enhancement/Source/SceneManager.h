@@ -10,10 +10,14 @@
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "SpatialIndex.h"
 #include "Octree.h"
+#include "SceneRegistry.h"
 #include "SceneNode.h"
+#include "FlatSceneGraph.h"
 #include "PerformanceProfiler.h"
 
 /***********************************************************
@@ -30,14 +34,42 @@ public:
 	// destructor
 	~SceneManager();
 
-    // Register a scene object in the octree
-    void RegisterSceneObject(const SceneObject& obj);
+    // Spatial index DefineSceneObjects builds for the static objects
+    enum class StaticIndexKind { Octree, BVH };
+    // Choose the static index; takes effect at the next PrepareScene. The Octree is the default
+    void SetStaticIndexKind(StaticIndexKind kind) { m_staticIndexKind = kind; }
+
+    // Register a scene object (once, at scene preparation); dynamic objects go to the hash grid
+    void RegisterSceneObject(const SceneObject& obj, bool dynamic = false);
+    // Re-index a registered object; no-op when its transform is unchanged.
+    // A static object that moves is handed over to the hash grid.
+    void UpdateSceneObject(const SceneObject& obj);
     // Query objects in a region (for frustum culling, etc.)
     void QueryObjectsInRegion(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const;
+    // Query objects whose bounding spheres touch the frustum
+    void QueryObjectsInFrustum(const Frustum& frustum, std::vector<int>& results) const;
+    // Camera matrices used to build the culling frustum for the next RenderScene
+    void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+    // Start culling the static objects on a worker thread, against the Octree snapshot
+    // published by the last PublishSceneChanges; RenderScene waits for it. Call after
+    // SetViewProjection. Does nothing when the static index is a BVH.
+    void BeginCulling();
+    // Frame boundary: make this frame's static index edits visible to the next cull
+    void PublishSceneChanges();
+    // Id of the nearest object whose bounding sphere the ray hits, or -1
+    int PickObject(const glm::vec3& origin, const glm::vec3& direction) const;
+    // Hand the scene graph's size and average nodes updated per frame to the profiler, then
+    // walk the static Octree and hand over its shape and memory use (skipped for a BVH)
+    void RecordSpatialIndexStats() const;
     
-    // Scene graph management
+    // Scene graph management: BuildSceneGraph links the lamp and plant parts into
+    // hierarchies (called from DefineSceneObjects); UpdateSceneGraph propagates
+    // transform changes once per frame and re-indexes the objects that moved
     void BuildSceneGraph();
     void UpdateSceneGraph();
+    // Threads UpdateSceneGraph may split large graph levels across (0 = all hardware
+    // threads). The default of 1 keeps it serial; the desk scene is far too small to gain.
+    void SetSceneGraphThreads(int threadCount) { m_sceneGraphThreads = threadCount; }
 
 	struct TEXTURE_INFO
 	{
@@ -55,6 +87,20 @@ public:
 		std::string tag;
 	};
 
+	struct RENDER_OBJECT
+	{
+		int id;
+		glm::vec3 pos;
+		glm::vec3 scale;
+		float xrot, yrot, zrot;
+		std::string texture;
+		std::string material;
+		std::string meshType;
+		float boundingRadius;
+		// Scene graph node placing this object, if any; its world transform replaces pos/rotation
+		const SceneNode* node = nullptr;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
@@ -67,11 +113,55 @@ private:
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
 
-    // Octree for spatial partitioning
-    Octree* m_octree;
+    // Spatial index of the static objects, of the kind chosen by SetStaticIndexKind
+    SpatialIndex* m_spatialIndex;
+    StaticIndexKind m_staticIndexKind;
+    // Hash grid of the objects that move, cheap to update every frame
+    SpatialIndex* m_dynamicIndex;
+    // Persistent record of the objects in both indexes
+    SceneRegistry* m_sceneRegistry;
+    // Camera frustum for culling, refreshed by SetViewProjection
+    Frustum m_frustum;
+    // Objects drawn by RenderScene, defined once in PrepareScene
+    std::vector<RENDER_OBJECT> m_renderObjects;
+    // Frustum query results, reused by RenderScene every frame
+    std::vector<int> m_visibleObjectIds;
+    // Octree culling state carried from frame to frame; unused when the static index is a BVH
+    Octree::CullCache m_cullCache;
+    // Static objects in the frustum, sorted, patched each frame with the changes below
+    std::vector<int> m_visibleStaticIds;
+    std::vector<int> m_becameVisible;
+    std::vector<int> m_becameHidden;
+    // Worker started by BeginCulling; it owns the culling state above until joined
+    std::thread m_cullWorker;
+    // Octree query counters of the last static cull, and of every static cull so far.
+    // The counters are per thread, so the worker's work is carried back in these.
+    OctreeQueryCounters m_lastCullCounters;
+    OctreeQueryCounters m_cullCounters;
     
     // Scene graph root node
     std::shared_ptr<SceneNode> m_sceneRoot;
+    // m_sceneRoot compiled into breadth-first arrays; UpdateSceneGraph updates the
+    // hierarchy through it in one linear pass instead of recursing from the root
+    FlatSceneGraph* m_sceneGraph;
+    // Nodes whose world transform changed in the last UpdateSceneGraph
+    std::vector<const SceneNode*> m_changedNodes;
+    // Thread count passed to FlatSceneGraph::update, set by SetSceneGraphThreads
+    int m_sceneGraphThreads;
+    // Nodes recomputed by every UpdateSceneGraph so far, and the number of calls
+    uint64_t m_sceneGraphNodesUpdated;
+    uint64_t m_sceneGraphUpdates;
+
+	// define the scene objects, pick the spatial index and register them in it
+	void DefineSceneObjects();
+	// push the world position of a scene graph node into the spatial index
+	void SyncSceneNodeToIndex(const SceneNode& node);
+	// fill m_visibleObjectIds for the current frustum, reusing last frame's static result where possible
+	void CullSceneObjects();
+	// patch m_visibleStaticIds with the visibility changes in an Octree snapshot; runs on the cull worker
+	void CullStaticObjects(const Octree& octree, const Frustum& frustum);
+	// join the cull worker, if BeginCulling started one
+	void WaitForCulling();
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
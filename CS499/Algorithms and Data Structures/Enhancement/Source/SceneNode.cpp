@@ -1,4 +1,5 @@
 #include "SceneNode.h"
+#include "FlatSceneGraph.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
 
@@ -7,6 +8,12 @@ SceneNode::SceneNode(const std::string& name)
     , m_parent(nullptr)
     , m_localTransform(1.0f)
     , m_worldTransform(1.0f)
+    , m_parentTransform(1.0f)
+    , m_localDirty(false)
+    , m_worldDirty(true)
+    , m_childDirty(false)
+    , m_flatGraph(nullptr)
+    , m_flatIndex(-1)
     , m_position(0.0f)
     , m_rotation(0.0f)
     , m_scale(1.0f)
@@ -15,6 +22,11 @@ SceneNode::SceneNode(const std::string& name)
 
 SceneNode::~SceneNode()
 {
+    // Children kept alive elsewhere must not flag a destroyed parent
+    for (auto& child : m_children)
+    {
+        child->m_parent = nullptr;
+    }
     m_children.clear();
 }
 
@@ -24,18 +36,30 @@ void SceneNode::addChild(std::shared_ptr<SceneNode> child)
     {
         child->m_parent = this;
         m_children.push_back(child);
+        child->markDirty();
+        if (m_flatGraph)
+            m_flatGraph->markStructureDirty();
     }
 }
 
 void SceneNode::removeChild(const std::string& name)
 {
-    m_children.erase(
-        std::remove_if(m_children.begin(), m_children.end(),
-            [&name](const std::shared_ptr<SceneNode>& node) {
-                return node->getName() == name;
-            }),
-        m_children.end()
-    );
+    // Partition rather than remove_if, which leaves the removed slots moved-from
+    auto removed = std::stable_partition(m_children.begin(), m_children.end(),
+        [&name](const std::shared_ptr<SceneNode>& node) {
+            return node->getName() != name;
+        });
+    for (auto it = removed; it != m_children.end(); ++it)
+    {
+        (*it)->m_parent = nullptr;
+        (*it)->markDirty();
+        if (m_flatGraph)
+        {
+            m_flatGraph->markStructureDirty();
+            (*it)->detachFromFlatGraph();
+        }
+    }
+    m_children.erase(removed, m_children.end());
 }
 
 std::shared_ptr<SceneNode> SceneNode::findChild(const std::string& name)
@@ -55,24 +79,36 @@ std::shared_ptr<SceneNode> SceneNode::findChild(const std::string& name)
 void SceneNode::setLocalTransform(const glm::mat4& transform)
 {
     m_localTransform = transform;
+    m_localDirty = false;
+    markDirty();
 }
 
 void SceneNode::setPosition(const glm::vec3& position)
 {
     m_position = position;
-    updateLocalTransform();
+    m_localDirty = true;
+    markDirty();
 }
 
 void SceneNode::setRotation(const glm::vec3& rotation)
 {
     m_rotation = rotation;
-    updateLocalTransform();
+    m_localDirty = true;
+    markDirty();
 }
 
 void SceneNode::setScale(const glm::vec3& scale)
 {
     m_scale = scale;
-    updateLocalTransform();
+    m_localDirty = true;
+    markDirty();
+}
+
+glm::mat4 SceneNode::getLocalTransform() const
+{
+    if (m_localDirty)
+        updateLocalTransform();
+    return m_localTransform;
 }
 
 glm::mat4 SceneNode::getWorldTransform() const
@@ -80,17 +116,60 @@ glm::mat4 SceneNode::getWorldTransform() const
     return m_worldTransform;
 }
 
-void SceneNode::update(const glm::mat4& parentTransform)
+// Flag this node and every ancestor up to the first one already flagged
+void SceneNode::markDirty()
+{
+    m_worldDirty = true;
+    if (m_flatGraph)
+        m_flatGraph->markDirty(m_flatIndex);
+    for (SceneNode* ancestor = m_parent; ancestor && !ancestor->m_childDirty; ancestor = ancestor->m_parent)
+    {
+        ancestor->m_childDirty = true;
+    }
+}
+
+// Removed subtrees stop writing into the graph they left
+void SceneNode::detachFromFlatGraph()
 {
-    m_worldTransform = parentTransform * m_localTransform;
+    m_flatGraph = nullptr;
+    m_flatIndex = -1;
+    for (auto& child : m_children)
+    {
+        child->detachFromFlatGraph();
+    }
+}
+
+void SceneNode::update(const glm::mat4& parentTransform, std::vector<const SceneNode*>* changed)
+{
+    // Called on a root (or a detached subtree) the parent transform is external, so compare it
+    bool parentChanged = parentTransform != m_parentTransform;
+    m_parentTransform = parentTransform;
+    updateSubtree(parentTransform, parentChanged, changed);
+}
+
+void SceneNode::updateSubtree(const glm::mat4& parentTransform, bool parentChanged, std::vector<const SceneNode*>* changed)
+{
+    bool recompute = parentChanged || m_worldDirty;
+    if (!recompute && !m_childDirty)
+        return;
+
+    if (recompute)
+    {
+        m_worldTransform = parentTransform * getLocalTransform();
+        m_parentTransform = parentTransform;
+        m_worldDirty = false;
+        if (changed)
+            changed->push_back(this);
+    }
+    m_childDirty = false;
     
     for (auto& child : m_children)
     {
-        child->update(m_worldTransform);
+        child->updateSubtree(m_worldTransform, recompute, changed);
     }
 }
 
-void SceneNode::updateLocalTransform()
+void SceneNode::updateLocalTransform() const
 {
     glm::mat4 translation = glm::translate(glm::mat4(1.0f), m_position);
     glm::mat4 rotX = glm::rotate(glm::mat4(1.0f), glm::radians(m_rotation.x), glm::vec3(1, 0, 0));
@@ -99,4 +178,5 @@ void SceneNode::updateLocalTransform()
     glm::mat4 scale = glm::scale(glm::mat4(1.0f), m_scale);
     
     m_localTransform = translation * rotX * rotY * rotZ * scale;
+    m_localDirty = false;
 }
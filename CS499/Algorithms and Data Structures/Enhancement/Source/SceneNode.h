@@ -4,11 +4,17 @@
 #include <string>
 #include <glm/glm.hpp>
 
+class FlatSceneGraph;
+
 /***********************************************************
  *  SceneNode
  *
  *  Hierarchical scene graph node for parent-child relationships
  *  Supports transformation propagation and scene organization
+ *
+ *  Transforms are propagated lazily: setters mark the node dirty
+ *  and flag its ancestors, so update() only descends into
+ *  subtrees that contain a change and skips the rest.
  ***********************************************************/
 class SceneNode
 {
@@ -28,11 +34,13 @@ public:
     void setScale(const glm::vec3& scale);
     
     // Get transforms
-    glm::mat4 getLocalTransform() const { return m_localTransform; }
+    glm::mat4 getLocalTransform() const;
     glm::mat4 getWorldTransform() const;
     
-    // Update hierarchy (propagate transforms)
-    void update(const glm::mat4& parentTransform = glm::mat4(1.0f));
+    // Update hierarchy (propagate transforms). Clean subtrees are skipped; nodes whose
+    // world transform was recomputed are appended to changed when it is given.
+    void update(const glm::mat4& parentTransform = glm::mat4(1.0f), std::vector<const SceneNode*>* changed = nullptr);
+    bool isDirty() const { return m_worldDirty || m_childDirty; }
     
     // Accessors
     const std::string& getName() const { return m_name; }
@@ -44,16 +52,29 @@ public:
     bool visible = true;
 
 private:
+    friend class FlatSceneGraph;
+
     std::string m_name;
     SceneNode* m_parent;
     std::vector<std::shared_ptr<SceneNode>> m_children;
     
-    glm::mat4 m_localTransform;
+    mutable glm::mat4 m_localTransform;
     glm::mat4 m_worldTransform;
+    glm::mat4 m_parentTransform; // Last parent transform passed to update() on this node
+    
+    mutable bool m_localDirty;   // Position/rotation/scale changed since the matrix was built
+    bool m_worldDirty;           // World transform must be recomputed
+    bool m_childDirty;           // Some descendant has a dirty world transform
+    
+    FlatSceneGraph* m_flatGraph; // Compiled graph holding this node, if any
+    int m_flatIndex;             // Entry in m_flatGraph's arrays
     
     glm::vec3 m_position;
     glm::vec3 m_rotation;
     glm::vec3 m_scale;
     
-    void updateLocalTransform();
+    void updateLocalTransform() const;
+    void markDirty();
+    void detachFromFlatGraph();
+    void updateSubtree(const glm::mat4& parentTransform, bool parentChanged, std::vector<const SceneNode*>* changed);
 };
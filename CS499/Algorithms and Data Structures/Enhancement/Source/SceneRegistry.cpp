@@ -0,0 +1,90 @@
+#include "SceneRegistry.h"
+
+SceneRegistry::SceneRegistry(SpatialIndex* index, SpatialIndex* dynamicIndex)
+    : m_index(index), m_dynamicIndex(dynamicIndex)
+{
+}
+
+bool SceneRegistry::registerObject(const SceneObject& obj, bool dynamic)
+{
+    Entry entry{ obj, dynamic && m_dynamicIndex != nullptr };
+    if (!m_objects.emplace(obj.id, entry).second)
+        return false;
+
+    SpatialIndex* index = indexFor(entry);
+    if (index) index->insert(obj);
+    return true;
+}
+
+void SceneRegistry::registerObjects(const std::vector<SceneObject>& objects)
+{
+    for (const auto& obj : objects)
+        m_objects.emplace(obj.id, Entry{ obj, false });
+    if (!m_index)
+        return;
+
+    std::vector<SceneObject> all;
+    all.reserve(m_objects.size());
+    for (const auto& entry : m_objects)
+    {
+        if (!entry.second.dynamic)
+            all.push_back(entry.second.object);
+    }
+    m_index->build(all);
+}
+
+bool SceneRegistry::updateObject(const SceneObject& obj)
+{
+    auto it = m_objects.find(obj.id);
+    if (it == m_objects.end())
+        return registerObject(obj);
+
+    // Static objects cost a lookup, not a tree walk
+    Entry& entry = it->second;
+    if (entry.object.position == obj.position && entry.object.boundingRadius == obj.boundingRadius)
+        return false;
+
+    entry.object = obj;
+    if (!entry.dynamic && m_dynamicIndex)
+    {
+        // First move: hand the object over to the dynamic index for good
+        if (m_index) m_index->remove(obj.id);
+        entry.dynamic = true;
+        m_dynamicIndex->insert(obj);
+        return true;
+    }
+
+    SpatialIndex* index = indexFor(entry);
+    if (index) index->update(obj.id, obj.position, obj.boundingRadius);
+    return true;
+}
+
+void SceneRegistry::unregisterObject(int objectId)
+{
+    auto it = m_objects.find(objectId);
+    if (it == m_objects.end())
+        return;
+
+    SpatialIndex* index = indexFor(it->second);
+    m_objects.erase(it);
+    if (index) index->remove(objectId);
+}
+
+void SceneRegistry::clear()
+{
+    m_objects.clear();
+    if (m_index) m_index->clear();
+    if (m_dynamicIndex) m_dynamicIndex->clear();
+}
+
+const SceneObject* SceneRegistry::find(int objectId) const
+{
+    auto it = m_objects.find(objectId);
+    return it != m_objects.end() ? &it->second.object : nullptr;
+}
+
+bool SceneRegistry::isDynamic(int objectId) const
+{
+    auto it = m_objects.find(objectId);
+    return it != m_objects.end() && it->second.dynamic;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "SpatialIndex.h"
+
+/***********************************************************
+ *  SceneRegistry
+ *
+ *  Persistent record of every object placed in the spatial
+ *  index. Objects are registered once; afterwards the index
+ *  is only touched when an object's transform changes.
+ *
+ *  With a dynamic index, objects registered as dynamic live
+ *  there instead, and a static object that moves is handed
+ *  over to it on its first move, so the static index keeps
+ *  only objects that stay put.
+ ***********************************************************/
+class SceneRegistry
+{
+public:
+    explicit SceneRegistry(SpatialIndex* index, SpatialIndex* dynamicIndex = nullptr);
+
+    // Add an object to the index, or to the dynamic index when dynamic and there is one
+    // (returns false if the id is already registered)
+    bool registerObject(const SceneObject& obj, bool dynamic = false);
+    // Add a batch of static objects and rebuild the index over every static object in
+    // one bulk build; ids that are already registered are skipped
+    void registerObjects(const std::vector<SceneObject>& objects);
+    // Re-index an object only if its position or radius changed (returns true if re-indexed).
+    // A static object that changes moves to the dynamic index, if there is one.
+    bool updateObject(const SceneObject& obj);
+    void unregisterObject(int objectId);
+    void clear();
+
+    const SceneObject* find(int objectId) const;
+    bool isDynamic(int objectId) const;
+    bool contains(int objectId) const { return m_objects.count(objectId) != 0; }
+    size_t size() const { return m_objects.size(); }
+
+private:
+    struct Entry
+    {
+        SceneObject object;
+        bool dynamic; // Indexed in m_dynamicIndex rather than m_index
+    };
+
+    SpatialIndex* m_index;
+    SpatialIndex* m_dynamicIndex;
+    std::unordered_map<int, Entry> m_objects;
+
+    SpatialIndex* indexFor(const Entry& entry) const { return entry.dynamic ? m_dynamicIndex : m_index; }
+};
@@ -0,0 +1,1158 @@
+#include "SpatialBenchmark.h"
+#include "Octree.h"
+#include "BVH.h"
+#include "ConcurrentOctree.h"
+#include "SpatialHashGrid.h"
+#include "SceneRegistry.h"
+#include "SceneNode.h"
+#include "FlatSceneGraph.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        std::chrono::duration<double, std::milli> duration = Clock::now() - start;
+        return duration.count();
+    }
+
+    // Objects scattered uniformly through a cube of the given half extent
+    std::vector<SceneObject> makeUniformObjects(int count, float halfExtent, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coord(-halfExtent, halfExtent);
+        std::uniform_real_distribution<float> radius(0.05f, 0.5f);
+
+        std::vector<SceneObject> objects;
+        objects.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            objects.push_back(SceneObject{ glm::vec3(coord(rng), coord(rng), coord(rng)), radius(rng), i });
+        }
+        return objects;
+    }
+
+    // Cube around every bounding sphere, as (center, half size)
+    void sceneCube(const std::vector<SceneObject>& objects, glm::vec3& center, float& halfSize)
+    {
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+        for (const auto& obj : objects)
+        {
+            boundsMin = glm::min(boundsMin, obj.position - glm::vec3(obj.boundingRadius));
+            boundsMax = glm::max(boundsMax, obj.position + glm::vec3(obj.boundingRadius));
+        }
+        if (objects.empty())
+        {
+            center = glm::vec3(0.0f);
+            halfSize = 1.0f;
+            return;
+        }
+        glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+        center = (boundsMin + boundsMax) * 0.5f;
+        halfSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1.0e-3f));
+    }
+
+    // Region boxes, camera frusta and rays spread over a scene's bounds
+    struct QueryWorkload
+    {
+        std::vector<glm::vec3> boxMin, boxMax;
+        std::vector<Frustum> frusta;
+        std::vector<glm::vec3> rayOrigins, rayDirections;
+    };
+
+    struct WorkloadTimes
+    {
+        double regionMs, frustumMs, rayMs;
+        double total() const { return regionMs + frustumMs + rayMs; }
+    };
+
+    QueryWorkload makeWorkload(const std::vector<SceneObject>& objects, int count, unsigned seed)
+    {
+        glm::vec3 center;
+        float halfSize;
+        sceneCube(objects, center, halfSize);
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        auto inScene = [&]() { return center + glm::vec3(unit(rng), unit(rng), unit(rng)) * halfSize; };
+        auto outside = [&]() {
+            glm::vec3 away(unit(rng), unit(rng), unit(rng));
+            return center + glm::normalize(away + glm::vec3(0.0f, 0.0f, 1.0e-3f)) * (halfSize * 1.8f);
+        };
+
+        QueryWorkload workload;
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, halfSize * 4.0f);
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec3 boxCenter = inScene();
+            workload.boxMin.push_back(boxCenter - glm::vec3(halfSize * 0.1f));
+            workload.boxMax.push_back(boxCenter + glm::vec3(halfSize * 0.1f));
+            workload.frusta.push_back(Frustum::fromMatrices(glm::lookAt(outside(), inScene(), glm::vec3(0.0f, 1.0f, 0.0f)), projection));
+            glm::vec3 origin = outside();
+            workload.rayOrigins.push_back(origin);
+            workload.rayDirections.push_back(inScene() - origin);
+        }
+        return workload;
+    }
+
+    WorkloadTimes timeWorkload(const SpatialIndex& index, const QueryWorkload& workload)
+    {
+        std::vector<int> results;
+        WorkloadTimes times;
+        auto start = Clock::now();
+        for (size_t i = 0; i < workload.boxMin.size(); ++i)
+        {
+            results.clear();
+            index.query(workload.boxMin[i], workload.boxMax[i], results);
+        }
+        times.regionMs = elapsedMs(start);
+        start = Clock::now();
+        for (const auto& frustum : workload.frusta)
+        {
+            results.clear();
+            index.queryFrustum(frustum, results);
+        }
+        times.frustumMs = elapsedMs(start);
+        start = Clock::now();
+        RayHit hit;
+        for (size_t i = 0; i < workload.rayOrigins.size(); ++i)
+            index.raycastFirst(workload.rayOrigins[i], workload.rayDirections[i], hit);
+        times.rayMs = elapsedMs(start);
+        return times;
+    }
+
+    // Best of a few passes, so one preempted pass does not decide
+    WorkloadTimes bestOfPasses(const SpatialIndex& index, const QueryWorkload& workload, int passes)
+    {
+        WorkloadTimes best = timeWorkload(index, workload);
+        for (int pass = 1; pass < passes; ++pass)
+        {
+            WorkloadTimes times = timeWorkload(index, workload);
+            best.regionMs = std::min(best.regionMs, times.regionMs);
+            best.frustumMs = std::min(best.frustumMs, times.frustumMs);
+            best.rayMs = std::min(best.rayMs, times.rayMs);
+        }
+        return best;
+    }
+
+    // Bytes of the image save() writes for a tree, or empty if it could not be written
+    std::string imageBytes(const Octree& octree, const char* path)
+    {
+        if (!octree.save(path))
+            return std::string();
+        std::ifstream image(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(image)), std::istreambuf_iterator<char>());
+        image.close();
+        std::remove(path);
+        return bytes;
+    }
+
+    void printFrameWindow(const char* label, const std::vector<double>& frameTimes, size_t first, size_t count)
+    {
+        double total = 0.0;
+        for (size_t i = first; i < first + count && i < frameTimes.size(); ++i)
+            total += frameTimes[i];
+        std::cout << "  " << label << ": " << std::fixed << std::setprecision(3) << (total / count) << " ms/frame\n";
+    }
+}
+
+void RunRegistryBenchmark(int objectCount, int frameCount)
+{
+    const float halfExtent = 9.0f;
+    const glm::vec3 regionMin(-8.0f, -2.0f, -8.0f);
+    const glm::vec3 regionMax(8.0f, 8.0f, 8.0f);
+    const size_t window = static_cast<size_t>(frameCount / 10 > 0 ? frameCount / 10 : 1);
+
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, halfExtent, 1234u);
+    std::vector<int> results;
+
+    std::cout << "=== Registry Benchmark (" << objectCount << " objects, " << frameCount << " frames) ===\n";
+
+    // Old behaviour: every frame inserts every object again. Octree::insert now
+    // replaces an existing id, so each frame uses fresh ids to reproduce the
+    // duplicate entries the old insert appended.
+    {
+        Octree octree(glm::vec3(0.0f), 10.0f, 5);
+        std::vector<double> frameTimes;
+        frameTimes.reserve(frameCount);
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            auto start = Clock::now();
+            results.clear();
+            octree.query(regionMin, regionMax, results);
+            for (const auto& obj : objects)
+            {
+                SceneObject copy = obj;
+                copy.id = frame * objectCount + obj.id;
+                octree.insert(copy);
+            }
+            frameTimes.push_back(elapsedMs(start));
+        }
+        std::cout << "Re-insert every frame (octree holds " << octree.size() << " entries at exit)\n";
+        printFrameWindow("first frames", frameTimes, 0, window);
+        printFrameWindow("last frames ", frameTimes, frameTimes.size() - window, window);
+    }
+
+    // Persistent registry: objects registered once, 1% move each frame
+    {
+        Octree octree(glm::vec3(0.0f), 10.0f, 5);
+        SceneRegistry registry(&octree);
+        for (const auto& obj : objects)
+            registry.registerObject(obj);
+
+        std::mt19937 rng(99u);
+        std::uniform_int_distribution<int> pick(0, objectCount - 1);
+        std::uniform_real_distribution<float> nudge(-0.05f, 0.05f);
+        const int movesPerFrame = objectCount / 100 > 0 ? objectCount / 100 : 1;
+
+        std::vector<double> frameTimes;
+        frameTimes.reserve(frameCount);
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            auto start = Clock::now();
+            results.clear();
+            octree.query(regionMin, regionMax, results);
+            for (int i = 0; i < movesPerFrame; ++i)
+            {
+                SceneObject& obj = objects[pick(rng)];
+                obj.position += glm::vec3(nudge(rng), nudge(rng), nudge(rng));
+                registry.updateObject(obj);
+            }
+            frameTimes.push_back(elapsedMs(start));
+        }
+        std::cout << "Persistent registry, " << movesPerFrame << " moves/frame (octree holds " << octree.size() << " entries at exit)\n";
+        printFrameWindow("first frames", frameTimes, 0, window);
+        printFrameWindow("last frames ", frameTimes, frameTimes.size() - window, window);
+    }
+
+    std::cout << "\n";
+}
+
+void RunRemoveBenchmark()
+{
+    const int sizes[] = { 1000, 10000, 100000, 1000000 };
+    const int removeCount = 1000;
+
+    std::cout << "=== Remove Benchmark (" << removeCount << " removals per tree) ===\n";
+    for (int size : sizes)
+    {
+        std::vector<SceneObject> objects = makeUniformObjects(size, 9.0f, 42u);
+        Octree octree(glm::vec3(0.0f), 10.0f, 5);
+        for (const auto& obj : objects)
+            octree.insert(obj);
+
+        // Despawn a random subset so removals hit nodes all over the tree
+        std::shuffle(objects.begin(), objects.end(), std::mt19937(7u));
+        auto start = Clock::now();
+        for (int i = 0; i < removeCount; ++i)
+            octree.remove(objects[i].id);
+        double ms = elapsedMs(start);
+
+        std::cout << "  " << std::setw(8) << size << " objects: "
+            << std::fixed << std::setprecision(1) << (ms * 1.0e6 / removeCount) << " ns/remove, "
+            << std::setprecision(0) << (removeCount / (ms / 1000.0)) << " removes/s\n";
+    }
+    std::cout << "\n";
+}
+
+void RunBuildBenchmark()
+{
+    const int sizes[] = { 10000, 100000, 1000000 };
+
+    std::cout << "=== Build Benchmark ===\n";
+    for (int size : sizes)
+    {
+        std::vector<SceneObject> objects = makeUniformObjects(size, 9.0f, 5u);
+
+        Octree incremental(glm::vec3(0.0f), 10.0f, 5);
+        auto start = Clock::now();
+        for (const auto& obj : objects)
+            incremental.insert(obj);
+        double insertMs = elapsedMs(start);
+
+        Octree bulk(glm::vec3(0.0f), 10.0f, 5);
+        start = Clock::now();
+        bulk.build(objects);
+        double buildMs = elapsedMs(start);
+
+        std::cout << "  " << std::setw(8) << size << " objects: insert " << std::fixed << std::setprecision(2)
+            << insertMs << " ms, bulk build " << buildMs << " ms\n";
+    }
+    std::cout << "\n";
+}
+
+void RunParallelBuildBenchmark()
+{
+    const int objectCount = 1000000;
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 5u);
+
+    std::cout << "=== Parallel Build Benchmark (" << objectCount << " objects, "
+        << std::thread::hardware_concurrency() << " hardware threads) ===\n";
+    const char* imagePath = "spatial_benchmark_parallel.octree";
+    double serialMs = 0.0;
+    std::string serialImage;
+    for (int threads : threadCounts)
+    {
+        Octree octree(glm::vec3(0.0f), 10.0f, 5);
+        auto start = Clock::now();
+        octree.build(objects, threads);
+        double ms = elapsedMs(start);
+
+        // The parallel build must lay the tree out exactly as the serial one does
+        std::string image = imageBytes(octree, imagePath);
+        if (threads == 1)
+        {
+            serialMs = ms;
+            serialImage = image;
+        }
+        bool identical = !image.empty() && image == serialImage;
+
+        std::cout << "  " << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(2)
+            << ms << " ms (" << (serialMs / ms) << "x)" << (identical ? "" : "  MISMATCH vs. serial") << "\n";
+    }
+    std::cout << "\n";
+}
+
+void RunLeafScanBenchmark()
+{
+    const int objectCount = 200000;
+    const int depths[] = { 1, 2, 3 };
+    const int repeats = 20;
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 11u);
+    const Frustum frustum = Frustum::fromMatrices(
+        glm::lookAt(glm::vec3(0.0f, 2.0f, 12.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 30.0f));
+
+    std::cout << "=== Leaf Scan Benchmark (" << objectCount << " objects) ===\n";
+    std::vector<int> results;
+    for (int depth : depths)
+    {
+        Octree octree(glm::vec3(0.0f), 10.0f, depth);
+        octree.build(objects);
+
+        auto start = Clock::now();
+        for (int i = 0; i < repeats; ++i)
+        {
+            results.clear();
+            octree.query(glm::vec3(-6.0f, -6.0f, -6.0f), glm::vec3(6.0f, 6.0f, 6.0f), results);
+        }
+        double regionMs = elapsedMs(start) / repeats;
+        size_t regionHits = results.size();
+
+        start = Clock::now();
+        for (int i = 0; i < repeats; ++i)
+        {
+            results.clear();
+            octree.queryFrustum(frustum, results);
+        }
+        double frustumMs = elapsedMs(start) / repeats;
+
+        std::cout << "  depth " << depth << " (~" << (objectCount >> (3 * depth)) << " objects/leaf): region "
+            << std::fixed << std::setprecision(3) << regionMs << " ms (" << regionHits << " hits), frustum "
+            << frustumMs << " ms (" << results.size() << " hits)\n";
+    }
+    std::cout << "\n";
+}
+
+void RunRaycastBenchmark(int objectCount)
+{
+    const int rayCount = 100000;
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 21u);
+    Octree octree(glm::vec3(0.0f), 10.0f, 5);
+    octree.build(objects);
+
+    // Rays from in front of the scene, fanned across it
+    std::mt19937 rng(8u);
+    std::uniform_real_distribution<float> spread(-9.0f, 9.0f);
+    std::uniform_real_distribution<float> tilt(-0.3f, 0.3f);
+    std::vector<glm::vec3> origins, directions;
+    for (int i = 0; i < rayCount; ++i)
+    {
+        origins.push_back(glm::vec3(spread(rng), spread(rng), 15.0f));
+        directions.push_back(glm::vec3(tilt(rng), tilt(rng), -1.0f));
+    }
+
+    std::cout << "=== Raycast Benchmark (" << objectCount << " objects, " << rayCount << " rays) ===\n";
+    RayHit hit;
+    int hits = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < rayCount; ++i)
+        hits += octree.raycastFirst(origins[i], directions[i], hit) ? 1 : 0;
+    double firstMs = elapsedMs(start);
+
+    std::vector<RayHit> allHits;
+    size_t throughHits = 0;
+    start = Clock::now();
+    for (int i = 0; i < rayCount / 10; ++i)
+    {
+        octree.raycastAll(origins[i], directions[i], allHits);
+        throughHits += allHits.size();
+    }
+    double allMs = elapsedMs(start);
+
+    std::cout << "  raycastFirst: " << std::fixed << std::setprecision(1) << (firstMs * 1.0e6 / rayCount) << " ns/ray ("
+        << hits << " hits)\n";
+    std::cout << "  raycastAll:   " << (allMs * 1.0e6 / (rayCount / 10)) << " ns/ray ("
+        << std::setprecision(1) << (static_cast<double>(throughHits) / (rayCount / 10)) << " spheres/ray)\n\n";
+}
+
+void RunProximityBenchmark(int objectCount)
+{
+    const int queryCount = 20000;
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 31u);
+    Octree octree(glm::vec3(0.0f), 10.0f, 5);
+    octree.build(objects);
+
+    std::mt19937 rng(4u);
+    std::uniform_real_distribution<float> coord(-9.0f, 9.0f);
+    std::vector<glm::vec3> points;
+    for (int i = 0; i < queryCount; ++i)
+        points.push_back(glm::vec3(coord(rng), coord(rng), coord(rng)));
+
+    std::cout << "=== Proximity Benchmark (" << objectCount << " objects, " << queryCount << " queries) ===\n";
+    std::vector<Neighbor> nearest;
+    const size_t ks[] = { 1, 8, 64 };
+    for (size_t k : ks)
+    {
+        auto start = Clock::now();
+        for (const auto& point : points)
+            octree.queryNearest(point, k, nearest);
+        std::cout << "  nearest k=" << std::setw(2) << k << ": " << std::fixed << std::setprecision(1)
+            << (elapsedMs(start) * 1.0e6 / queryCount) << " ns/query\n";
+    }
+
+    std::vector<int> inside;
+    const float radii[] = { 0.5f, 2.0f };
+    for (float radius : radii)
+    {
+        size_t found = 0;
+        auto start = Clock::now();
+        for (const auto& point : points)
+        {
+            inside.clear();
+            octree.querySphere(point, radius, inside);
+            found += inside.size();
+        }
+        std::cout << "  sphere r=" << std::setprecision(1) << radius << ": " << (elapsedMs(start) * 1.0e6 / queryCount)
+            << " ns/query (" << (static_cast<double>(found) / queryCount) << " hits)\n";
+    }
+    std::cout << "\n";
+}
+
+void RunOverlappingPairsBenchmark(int objectCount)
+{
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 101u);
+    Octree octree(glm::vec3(0.0f), 10.0f, 5);
+    octree.build(objects);
+
+    std::cout << "=== Overlapping Pairs Benchmark (" << objectCount << " objects, "
+        << std::thread::hardware_concurrency() << " hardware threads) ===\n";
+
+    // The per-object alternative: a sphere query reaching the largest possible partner,
+    // then the exact test, keeping each pair from its smaller id
+    float maxRadius = 0.0f;
+    for (const auto& obj : objects) maxRadius = std::max(maxRadius, obj.boundingRadius);
+    std::vector<int> nearby;
+    size_t sphereQueryPairs = 0;
+    auto start = Clock::now();
+    for (const auto& obj : objects)
+    {
+        nearby.clear();
+        octree.querySphere(obj.position, obj.boundingRadius + maxRadius, nearby);
+        for (int id : nearby)
+        {
+            const SceneObject& other = objects[id];
+            float reach = obj.boundingRadius + other.boundingRadius;
+            glm::vec3 offset = other.position - obj.position;
+            if (obj.id < id && glm::dot(offset, offset) <= reach * reach)
+                ++sphereQueryPairs;
+        }
+    }
+    double sphereMs = elapsedMs(start);
+    std::cout << "  querySphere per object: " << std::fixed << std::setprecision(2) << sphereMs << " ms ("
+        << sphereQueryPairs << " pairs)\n";
+
+    std::vector<std::pair<int, int> > pairs;
+    double serialMs = 0.0;
+    for (int threads : threadCounts)
+    {
+        pairs.clear();
+        start = Clock::now();
+        octree.queryOverlappingPairs(pairs, threads);
+        double ms = elapsedMs(start);
+        if (threads == 1)
+            serialMs = ms;
+        std::cout << "  " << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(2)
+            << ms << " ms (" << (serialMs / ms) << "x, " << pairs.size() << " pairs)\n";
+    }
+    std::cout << "\n";
+}
+
+void RunVisitorQueryBenchmark(int objectCount)
+{
+    const int queryCount = 200;
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 71u);
+    Octree octree(glm::vec3(0.0f), 10.0f, 5);
+    octree.build(objects);
+    QueryWorkload workload = makeWorkload(objects, queryCount, 72u);
+
+    std::cout << "=== Visitor Query Benchmark (" << objectCount << " objects, " << queryCount << " frustum queries) ===\n";
+    auto report = [&](const char* label, double ms, size_t found) {
+        std::cout << "  " << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1)
+            << (ms * 1.0e3 / queryCount) << " us/query (" << (found / queryCount) << " visible)\n";
+    };
+
+    // What RenderScene used to do: a fresh vector every frame
+    size_t found = 0;
+    auto start = Clock::now();
+    for (const auto& frustum : workload.frusta)
+    {
+        std::vector<int> visible;
+        octree.queryFrustum(frustum, visible);
+        found += visible.size();
+    }
+    report("fresh vector", elapsedMs(start), found);
+
+    std::vector<int> reused;
+    found = 0;
+    start = Clock::now();
+    for (const auto& frustum : workload.frusta)
+    {
+        reused.clear();
+        octree.queryFrustum(frustum, reused);
+        found += reused.size();
+    }
+    report("reused vector", elapsedMs(start), found);
+
+    std::vector<int> buffer(objects.size());
+    found = 0;
+    start = Clock::now();
+    for (const auto& frustum : workload.frusta)
+    {
+        IdSpan visible(buffer.data(), buffer.size());
+        octree.queryFrustum(frustum, visible);
+        found += visible.size();
+    }
+    report("IdSpan", elapsedMs(start), found);
+
+    found = 0;
+    start = Clock::now();
+    for (const auto& frustum : workload.frusta)
+        octree.queryFrustum(frustum, [&found](int) { ++found; });
+    report("counting visitor", elapsedMs(start), found);
+    std::cout << "\n";
+}
+
+void RunImageBenchmark(int objectCount)
+{
+    const int queryCount = 1000;
+    const char* imagePath = "spatial_benchmark.octree";
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 41u);
+
+    std::cout << "=== Image Benchmark (" << objectCount << " objects) ===\n";
+    auto start = Clock::now();
+    Octree built(glm::vec3(0.0f), 10.0f, 5);
+    built.build(objects);
+    double buildMs = elapsedMs(start);
+    if (!built.save(imagePath))
+    {
+        std::cout << "  could not write " << imagePath << "\n\n";
+        return;
+    }
+
+    std::mt19937 rng(8u);
+    std::uniform_real_distribution<float> coord(-9.0f, 9.0f);
+    std::vector<glm::vec3> points;
+    for (int i = 0; i < queryCount; ++i)
+        points.push_back(glm::vec3(coord(rng), coord(rng), coord(rng)));
+
+    // Startup cost is load plus whatever the first queries fault in
+    std::vector<int> results;
+    start = Clock::now();
+    Octree mapped(glm::vec3(0.0f), 1.0f);
+    bool loaded = mapped.load(imagePath);
+    double loadMs = elapsedMs(start);
+    if (loaded)
+    {
+        for (const auto& point : points)
+        {
+            results.clear();
+            mapped.query(point - glm::vec3(0.25f), point + glm::vec3(0.25f), results);
+        }
+    }
+    double firstQueriesMs = elapsedMs(start) - loadMs;
+
+    std::ifstream image(imagePath, std::ios::binary | std::ios::ate);
+    double imageBytes = static_cast<double>(image.tellg());
+    image.close();
+    std::remove(imagePath);
+    if (!loaded)
+    {
+        std::cout << "  could not map " << imagePath << "\n\n";
+        return;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "  bulk build:             " << buildMs << " ms\n"
+        << "  load (map image):       " << loadMs << " ms\n"
+        << "  first " << queryCount << " region queries: " << firstQueriesMs << " ms\n"
+        << "  image size:             " << std::setprecision(1) << (imageBytes / objectCount) << " bytes/object\n\n";
+}
+
+void RunIndexComparisonBenchmark(int objectCount)
+{
+    const int queryCount = 2000;
+    std::mt19937 rng(17u);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Desk-like mix: a few large flat-ish objects among many small ones
+    std::vector<SceneObject> mixed = makeUniformObjects(objectCount, 9.0f, 51u);
+    for (auto& obj : mixed)
+    {
+        obj.boundingRadius = unit(rng) < 0.01f ? 2.0f + 4.0f * unit(rng) : 0.02f + 0.08f * unit(rng);
+        obj.position.y *= 0.1f;
+    }
+    // Tight clusters with empty space between them
+    std::vector<SceneObject> clustered = makeUniformObjects(objectCount, 0.4f, 52u);
+    std::vector<glm::vec3> clusterCenters;
+    for (int c = 0; c < 32; ++c)
+        clusterCenters.push_back(glm::vec3(unit(rng), unit(rng), unit(rng)) * 18.0f - glm::vec3(9.0f));
+    for (size_t i = 0; i < clustered.size(); ++i)
+        clustered[i].position += clusterCenters[i % clusterCenters.size()];
+
+    struct Scene { const char* label; std::vector<SceneObject> objects; };
+    Scene scenes[] = {
+        { "uniform", makeUniformObjects(objectCount, 9.0f, 50u) },
+        { "mixed sizes", mixed },
+        { "clustered", clustered },
+    };
+
+    std::cout << "=== Index Comparison Benchmark (" << objectCount << " objects, " << queryCount << " queries of each kind) ===\n";
+    for (const auto& scene : scenes)
+    {
+        glm::vec3 center;
+        float halfSize;
+        sceneCube(scene.objects, center, halfSize);
+        QueryWorkload workload = makeWorkload(scene.objects, queryCount, 6u);
+
+        Octree octree(center, halfSize);
+        BVH bvh;
+        SpatialHashGrid grid;
+        SpatialIndex* indexes[] = { &octree, &bvh, &grid };
+        double octreeMs = 0.0;
+        double bvhMs = 0.0;
+        std::cout << "  " << scene.label << ":\n";
+        for (SpatialIndex* index : indexes)
+        {
+            auto start = Clock::now();
+            index->build(scene.objects);
+            double buildMs = elapsedMs(start);
+            WorkloadTimes times = bestOfPasses(*index, workload, 2);
+            if (index == &octree)
+                octreeMs = times.total();
+            else if (index == &bvh)
+                bvhMs = times.total();
+
+            // Small moves of every tenth object: a re-insert for the octree, a refit for the BVH,
+            // an in-place write for the grid
+            start = Clock::now();
+            int moved = 0;
+            for (size_t i = 0; i < scene.objects.size(); i += 10, ++moved)
+            {
+                const SceneObject& obj = scene.objects[i];
+                index->update(obj.id, obj.position + glm::vec3(0.01f), obj.boundingRadius);
+            }
+            double moveNs = elapsedMs(start) * 1.0e6 / std::max(moved, 1);
+
+            std::cout << "    " << std::left << std::setw(9) << index->name() << std::right << std::fixed << std::setprecision(2)
+                << "build " << std::setw(7) << buildMs << " ms, region " << std::setw(8) << (times.regionMs * 1.0e6 / queryCount)
+                << " ns, frustum " << std::setw(9) << (times.frustumMs * 1.0e6 / queryCount)
+                << " ns, ray " << std::setw(7) << (times.rayMs * 1.0e6 / queryCount)
+                << " ns, move " << std::setw(6) << moveNs << " ns\n";
+        }
+        std::cout << "    faster static index: " << (bvhMs < octreeMs ? bvh.name() : octree.name()) << "\n";
+    }
+    std::cout << "\n";
+}
+
+void RunDynamicSceneBenchmark(int objectCount, int frameCount)
+{
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 40.0f);
+    const Frustum frustum = Frustum::fromMatrices(glm::lookAt(glm::vec3(0.0f, 4.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), projection);
+    const std::vector<SceneObject> start = makeUniformObjects(objectCount, 9.0f, 61u);
+
+    // Objects drift on fixed velocities, bouncing off the walls of the scene cube
+    std::mt19937 rng(62u);
+    std::uniform_real_distribution<float> speed(-0.05f, 0.05f);
+    std::vector<glm::vec3> startVelocities;
+    startVelocities.reserve(start.size());
+    for (size_t i = 0; i < start.size(); ++i)
+        startVelocities.push_back(glm::vec3(speed(rng), speed(rng), speed(rng)));
+    auto step = [](SceneObject& obj, glm::vec3& velocity) {
+        obj.position += velocity;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (std::abs(obj.position[axis]) > 9.0f)
+                velocity[axis] = -velocity[axis];
+        }
+    };
+
+    std::cout << "=== Dynamic Scene Benchmark (" << objectCount << " objects, " << frameCount << " frames) ===\n";
+    std::vector<int> results;
+
+    // Every object moves every frame, then one frustum query
+    {
+        Octree octree(glm::vec3(0.0f), 10.0f);
+        BVH bvh;
+        SpatialHashGrid grid;
+        SpatialIndex* indexes[] = { &octree, &bvh, &grid };
+        std::cout << "  all objects moving:\n";
+        for (SpatialIndex* index : indexes)
+        {
+            std::vector<SceneObject> objects = start;
+            std::vector<glm::vec3> velocities = startVelocities;
+            index->build(objects);
+            size_t visible = 0;
+            auto begin = Clock::now();
+            for (int frame = 0; frame < frameCount; ++frame)
+            {
+                for (size_t i = 0; i < objects.size(); ++i)
+                {
+                    step(objects[i], velocities[i]);
+                    index->update(objects[i].id, objects[i].position, objects[i].boundingRadius);
+                }
+                results.clear();
+                index->queryFrustum(frustum, results);
+                visible += results.size();
+            }
+            std::cout << "    " << std::left << std::setw(9) << index->name() << std::right << std::fixed << std::setprecision(3)
+                << (elapsedMs(begin) / frameCount) << " ms/frame (" << (visible / frameCount) << " visible)\n";
+        }
+    }
+
+    // One object in ten moves: all in the octree vs. movers handed over to the grid
+    {
+        const char* labels[] = { "octree only      ", "octree + grid    " };
+        for (int split = 0; split < 2; ++split)
+        {
+            std::vector<SceneObject> objects = start;
+            std::vector<glm::vec3> velocities = startVelocities;
+            Octree octree(glm::vec3(0.0f), 10.0f);
+            SpatialHashGrid grid(SpatialHashGrid::cellSizeFor(objects));
+            SceneRegistry registry(&octree, split ? &grid : nullptr);
+            registry.registerObjects(objects);
+            auto begin = Clock::now();
+            for (int frame = 0; frame < frameCount; ++frame)
+            {
+                for (size_t i = 0; i < objects.size(); i += 10)
+                {
+                    step(objects[i], velocities[i]);
+                    registry.updateObject(objects[i]);
+                }
+                results.clear();
+                octree.queryFrustum(frustum, results);
+                grid.queryFrustum(frustum, results);
+            }
+            std::cout << "  " << labels[split] << std::fixed << std::setprecision(3) << (elapsedMs(begin) / frameCount)
+                << " ms/frame (octree " << octree.size() << ", grid " << grid.size() << ")\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+void RunCoherentCullingBenchmark(int objectCount, int frameCount)
+{
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 81u);
+    Octree octree(glm::vec3(0.0f), 10.0f, 5);
+    octree.build(objects);
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 30.0f);
+
+    std::cout << "=== Coherent Culling Benchmark (" << objectCount << " objects, " << frameCount << " frames) ===\n";
+    const float degreesPerFrame[] = { 0.05f, 0.25f, 1.0f };
+    for (float step : degreesPerFrame)
+    {
+        // Orbit just outside the scene, looking at a point that sways around the center
+        std::vector<Frustum> frusta;
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            float angle = glm::radians(step * frame);
+            glm::vec3 eye(std::cos(angle) * 14.0f, 3.0f, std::sin(angle) * 14.0f);
+            glm::vec3 target(std::sin(angle * 3.0f) * 2.0f, 0.0f, 0.0f);
+            frusta.push_back(Frustum::fromMatrices(glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)), projection));
+        }
+
+        std::vector<int> visible;
+        size_t found = 0;
+        auto start = Clock::now();
+        for (const auto& frustum : frusta)
+        {
+            visible.clear();
+            octree.queryFrustum(frustum, visible);
+            found += visible.size();
+        }
+        double fullMs = elapsedMs(start);
+
+        // The first call is a full pass; keep it out of the per-frame figure
+        Octree::CullCache cache;
+        std::vector<int> becameVisible, becameHidden;
+        octree.queryFrustumChanges(frusta[0], cache, becameVisible, becameHidden);
+        size_t changes = 0;
+        start = Clock::now();
+        for (const auto& frustum : frusta)
+        {
+            becameVisible.clear();
+            becameHidden.clear();
+            octree.queryFrustumChanges(frustum, cache, becameVisible, becameHidden);
+            changes += becameVisible.size() + becameHidden.size();
+        }
+        double coherentMs = elapsedMs(start);
+
+        std::cout << "  " << std::fixed << std::setprecision(2) << step << " deg/frame: full "
+            << std::setprecision(1) << (fullMs * 1.0e3 / frameCount) << " us/frame (" << (found / frameCount)
+            << " visible), changes " << (coherentMs * 1.0e3 / frameCount) << " us/frame ("
+            << (static_cast<double>(changes) / frameCount) << " deltas)\n";
+    }
+    std::cout << "\n";
+}
+
+void RunConcurrentCullingBenchmark(int objectCount, int frameCount)
+{
+    std::vector<SceneObject> objects = makeUniformObjects(objectCount, 9.0f, 91u);
+    QueryWorkload workload = makeWorkload(objects, frameCount, 92u);
+    const int movesPerFrame = std::max(objectCount / 100, 1);
+
+    std::cout << "=== Concurrent Culling Benchmark (" << objectCount << " objects, " << movesPerFrame
+        << " moves and one frustum query per frame, " << std::thread::hardware_concurrency() << " hardware threads) ===\n";
+    for (int overlapped = 0; overlapped < 2; ++overlapped)
+    {
+        ConcurrentOctree tree(glm::vec3(0.0f), 10.0f, 5);
+        tree.build(objects);
+        tree.publish();
+        std::vector<SceneObject> moving = objects;
+        std::mt19937 rng(93u);
+        std::uniform_real_distribution<float> step(-0.1f, 0.1f);
+        auto moveObjects = [&]() {
+            for (int i = 0; i < movesPerFrame; ++i)
+            {
+                SceneObject& obj = moving[rng() % moving.size()];
+                obj.position = glm::clamp(obj.position + glm::vec3(step(rng), step(rng), step(rng)), glm::vec3(-9.0f), glm::vec3(9.0f));
+                tree.update(obj.id, obj.position, obj.boundingRadius);
+            }
+        };
+
+        std::vector<int> visible;
+        size_t found = 0;
+        auto start = Clock::now();
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            const Frustum& frustum = workload.frusta[frame];
+            auto cull = [&]() {
+                visible.clear();
+                tree.snapshot()->queryFrustum(frustum, visible);
+                found += visible.size();
+            };
+            if (overlapped)
+            {
+                // Cull the published frame while the next one is edited
+                std::thread worker(cull);
+                moveObjects();
+                worker.join();
+            }
+            else
+            {
+                moveObjects();
+                cull();
+            }
+            tree.publish();
+        }
+        std::cout << "  " << (overlapped ? "culling on a worker  " : "edit then cull       ") << std::fixed << std::setprecision(3)
+            << (elapsedMs(start) / frameCount) << " ms/frame (" << (found / frameCount) << " visible)\n";
+    }
+    std::cout << "\n";
+}
+
+void RunSceneGraphBenchmark(int deskCount, int frameCount)
+{
+    // Each desk: a top with a lamp (base -> neck -> shade), a plant (pot -> foliage) and books
+    std::mt19937 rng(31u);
+    std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+    auto root = std::make_shared<SceneNode>("root");
+    std::vector<std::shared_ptr<SceneNode> > desks;
+    for (int d = 0; d < deskCount; ++d)
+    {
+        auto desk = std::make_shared<SceneNode>("desk" + std::to_string(d));
+        desk->setPosition(glm::vec3(static_cast<float>(d % 100) * 3.0f, 0.0f, static_cast<float>(d / 100) * 3.0f));
+        auto lampBase = std::make_shared<SceneNode>("lamp_base");
+        auto lampNeck = std::make_shared<SceneNode>("lamp_neck");
+        auto lampShade = std::make_shared<SceneNode>("lamp_shade");
+        lampNeck->setRotation(glm::vec3(0.0f, 0.0f, 30.0f));
+        lampShade->setPosition(glm::vec3(0.6f, 0.9f, 0.0f));
+        lampNeck->addChild(lampShade);
+        lampBase->addChild(lampNeck);
+        desk->addChild(lampBase);
+        auto plantPot = std::make_shared<SceneNode>("plant_pot");
+        plantPot->addChild(std::make_shared<SceneNode>("plant_foliage"));
+        desk->addChild(plantPot);
+        for (int b = 0; b < 4; ++b)
+        {
+            auto book = std::make_shared<SceneNode>("book" + std::to_string(b));
+            book->setPosition(glm::vec3(offset(rng), 0.8f, offset(rng)));
+            desk->addChild(book);
+        }
+        root->addChild(desk);
+        desks.push_back(desk);
+    }
+
+    FlatSceneGraph graph(root);
+    graph.update();
+    std::cout << "=== Scene Graph Update Benchmark (" << deskCount << " desks, " << graph.size() << " nodes, "
+        << graph.levelCount() << " levels) ===\n";
+
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    std::vector<glm::mat4> serialWorlds;
+    std::vector<const SceneNode*> serialChanged;
+    std::vector<const SceneNode*> changed;
+    for (int moving = 0; moving < 2; ++moving)
+    {
+        std::cout << (moving == 0 ? "  every node moving:\n" : "  1% of desks moving:\n");
+        double serialMs = 0.0;
+        for (int threads : threadCounts)
+        {
+            // Same frame sequence for every thread count, from the same starting transforms;
+            // this untimed pass also starts the graph's worker pool for this thread count
+            std::mt19937 frameRng(77u);
+            for (auto& desk : desks) desk->setRotation(glm::vec3(0.0f));
+            graph.update(glm::mat4(1.0f), nullptr, threads);
+
+            double ms = 0.0;
+            for (int frame = 1; frame <= frameCount; ++frame)
+            {
+                glm::mat4 parent(1.0f);
+                if (moving == 0)
+                    parent = glm::rotate(glm::mat4(1.0f), 0.01f * frame, glm::vec3(0.0f, 1.0f, 0.0f));
+                else
+                    for (int d = 0; d < deskCount / 100; ++d)
+                        desks[frameRng() % desks.size()]->setRotation(glm::vec3(0.0f, static_cast<float>(frame), 0.0f));
+
+                changed.clear();
+                auto start = Clock::now();
+                graph.update(parent, &changed, threads);
+                ms += elapsedMs(start);
+            }
+            if (threads == 1)
+            {
+                serialMs = ms;
+                serialChanged = changed;
+                serialWorlds = graph.getWorldTransforms();
+            }
+            bool identical = changed == serialChanged && graph.getWorldTransforms() == serialWorlds;
+
+            std::cout << "    " << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(3)
+                << (ms / frameCount) << " ms/frame (" << std::setprecision(2) << (serialMs / ms) << "x vs. serial flat update), "
+                << changed.size() << " changed" << (identical ? "" : "  MISMATCH vs. serial") << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+void RunSpatialBenchmarks()
+{
+    RunRegistryBenchmark(10000, 200);
+    RunRemoveBenchmark();
+    RunBuildBenchmark();
+    RunParallelBuildBenchmark();
+    RunLeafScanBenchmark();
+    RunRaycastBenchmark(100000);
+    RunProximityBenchmark(100000);
+    RunOverlappingPairsBenchmark(100000);
+    RunVisitorQueryBenchmark(100000);
+    RunImageBenchmark(1000000);
+    RunIndexComparisonBenchmark(100000);
+    RunDynamicSceneBenchmark(100000, 20);
+    RunCoherentCullingBenchmark(100000, 300);
+    RunConcurrentCullingBenchmark(100000, 100);
+    RunSceneGraphBenchmark(5000, 20);
+}
+
+namespace
+{
+    enum Distribution { Uniform, Clustered, Coplanar };
+
+    // count objects at the density of 100k objects in the +/-9 cube used elsewhere
+    std::vector<SceneObject> makeScalingObjects(Distribution distribution, int count, unsigned seed)
+    {
+        const float halfExtent = 9.0f * std::cbrt(count / 100000.0f);
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> radius(0.05f, 0.5f);
+        std::normal_distribution<float> spread(0.0f, halfExtent * 0.05f);
+        std::vector<glm::vec3> clusterCenters;
+        for (int c = 0; c < 64; ++c)
+            clusterCenters.push_back(glm::vec3(unit(rng), unit(rng), unit(rng)) * (halfExtent * 0.9f));
+
+        std::vector<SceneObject> objects;
+        objects.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            glm::vec3 position;
+            if (distribution == Uniform)
+                position = glm::vec3(unit(rng), unit(rng), unit(rng)) * halfExtent;
+            else if (distribution == Clustered)
+                position = clusterCenters[i % clusterCenters.size()] + glm::vec3(spread(rng), spread(rng), spread(rng));
+            else
+                position = glm::vec3(unit(rng) * halfExtent * 5.0f, 0.0f, unit(rng) * halfExtent * 5.0f); // A wide flat sheet
+            objects.push_back(SceneObject{ position, radius(rng), i });
+        }
+        return objects;
+    }
+
+    // Depth that leaves about eight objects per leaf for a uniform scene
+    int scalingDepth(int count)
+    {
+        int depth = 1;
+        while (depth < 10 && std::pow(8.0, depth) * 8.0 < count) ++depth;
+        return depth;
+    }
+
+    double nsPerOp(double ms, size_t operations)
+    {
+        return operations > 0 ? ms * 1.0e6 / operations : 0.0;
+    }
+}
+
+void RunScalingBenchmark(int maxObjects)
+{
+    const int queryCount = 1000;
+    const int frustumCount = 50;
+    const char* labels[] = { "uniform", "clustered", "coplanar" };
+
+    std::cout << "=== Scaling Benchmark (1000 to " << maxObjects << " objects, ns/op) ===\n";
+    std::cout << "  scene       objects depth     build    insert    remove       box   frustum       ray       knn  bytes/obj\n";
+    for (int distribution = Uniform; distribution <= Coplanar; ++distribution)
+    {
+        for (int count = 1000; count <= maxObjects; count *= 10)
+        {
+            std::vector<SceneObject> objects = makeScalingObjects(static_cast<Distribution>(distribution), count, 200u + distribution);
+            glm::vec3 center;
+            float halfSize;
+            sceneCube(objects, center, halfSize);
+            const int depth = scalingDepth(count);
+            QueryWorkload workload = makeWorkload(objects, queryCount, 300u + distribution);
+
+            Octree octree(center, halfSize, depth);
+            auto start = Clock::now();
+            octree.build(objects);
+            double buildNs = nsPerOp(elapsedMs(start), objects.size());
+            const double bytesPerObject = static_cast<double>(octree.computeStats().bytesUsed) / count;
+
+            double insertNs;
+            {
+                Octree incremental(center, halfSize, depth);
+                start = Clock::now();
+                for (const auto& obj : objects) incremental.insert(obj);
+                insertNs = nsPerOp(elapsedMs(start), objects.size());
+            }
+
+            // Fixed-size boxes around objects, so results stay comparable as the scene grows
+            std::vector<int> results;
+            size_t found = 0;
+            start = Clock::now();
+            for (int i = 0; i < queryCount; ++i)
+            {
+                const glm::vec3& around = objects[(static_cast<size_t>(i) * 7919u) % objects.size()].position;
+                results.clear();
+                octree.query(around - glm::vec3(1.0f), around + glm::vec3(1.0f), results);
+                found += results.size();
+            }
+            double boxNs = nsPerOp(elapsedMs(start), queryCount);
+
+            start = Clock::now();
+            for (int i = 0; i < frustumCount; ++i)
+            {
+                results.clear();
+                octree.queryFrustum(workload.frusta[i], results);
+                found += results.size();
+            }
+            double frustumNs = nsPerOp(elapsedMs(start), frustumCount);
+
+            RayHit hit;
+            start = Clock::now();
+            for (int i = 0; i < queryCount; ++i)
+                found += octree.raycastFirst(workload.rayOrigins[i], workload.rayDirections[i], hit) ? 1 : 0;
+            double rayNs = nsPerOp(elapsedMs(start), queryCount);
+
+            std::vector<Neighbor> neighbors;
+            start = Clock::now();
+            for (int i = 0; i < queryCount; ++i)
+            {
+                octree.queryNearest((workload.boxMin[i] + workload.boxMax[i]) * 0.5f, 8, neighbors);
+                found += neighbors.size();
+            }
+            double knnNs = nsPerOp(elapsedMs(start), queryCount);
+
+            // Last, as it empties part of the tree: a tenth of the objects in random order
+            std::vector<int> removals;
+            std::mt19937 rng(400u);
+            for (int i = 0; i < count / 10; ++i) removals.push_back(static_cast<int>(rng() % count));
+            start = Clock::now();
+            for (int id : removals) octree.remove(id);
+            double removeNs = nsPerOp(elapsedMs(start), removals.size());
+
+            std::cout << "  " << std::left << std::setw(10) << labels[distribution] << std::right << std::setw(10) << count
+                << std::setw(6) << depth << std::fixed << std::setprecision(0)
+                << std::setw(10) << buildNs << std::setw(10) << insertNs << std::setw(10) << removeNs
+                << std::setw(10) << boxNs << std::setw(10) << frustumNs << std::setw(10) << rayNs << std::setw(10) << knnNs
+                << std::setprecision(1) << std::setw(11) << bytesPerObject
+                << (found == 0 ? "  (no results)" : "") << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+#ifdef SPATIAL_BENCHMARK_MAIN
+// Standalone benchmark executable with no window or GL dependency, built by the
+// spatial_benchmark target in CMakeLists.txt (which defines SPATIAL_BENCHMARK_MAIN)
+// Usage: spatial_benchmark [maxObjects] [--all]
+//   maxObjects  largest scene for the scaling run (default 10000000)
+//   --all       also run every other benchmark (RunSpatialBenchmarks)
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+    int maxObjects = 10000000;
+    bool all = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--all") == 0)
+            all = true;
+        else if (std::atoi(argv[i]) >= 1000)
+            maxObjects = std::atoi(argv[i]);
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [maxObjects >= 1000] [--all]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    RunScalingBenchmark(maxObjects);
+    if (all)
+        RunSpatialBenchmarks();
+    return EXIT_SUCCESS;
+}
+#endif
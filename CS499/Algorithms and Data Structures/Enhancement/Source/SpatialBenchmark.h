@@ -0,0 +1,75 @@
+#pragma once
+
+/***********************************************************
+ *  SpatialBenchmark
+ *
+ *  Headless timing runs for the spatial index on synthetic
+ *  scenes. Does not touch OpenGL, so it can run before any
+ *  window is created (see the --benchmark flag in MainCode).
+ ***********************************************************/
+
+#include <vector>
+#include "SpatialIndex.h"
+
+// Run every spatial index benchmark and print results to the console
+void RunSpatialBenchmarks();
+
+// Octree insert, bulk build, remove, box, frustum, ray and kNN cost in ns/op plus bytes
+// per object, for 1k objects up to maxObjects in steps of 10, on uniform, clustered and
+// coplanar scenes. Density is kept constant, so the scene grows with the object count.
+// The spatial_benchmark target in CMakeLists.txt builds a standalone, GL-free
+// executable that runs this (see the end of SpatialBenchmark.cpp).
+void RunScalingBenchmark(int maxObjects);
+
+// Per-frame cost of re-inserting every object vs. a persistent registry
+void RunRegistryBenchmark(int objectCount, int frameCount);
+
+// Removal throughput (removes/second) as the tree grows
+void RunRemoveBenchmark();
+
+// One-by-one insert vs. Morton-sorted bulk build
+void RunBuildBenchmark();
+
+// Bulk build time for 1..16 threads, relative to the serial build; checks that each
+// thread count saves the same image as the serial build
+void RunParallelBuildBenchmark();
+
+// Region and frustum query cost on shallow trees with dense leaves
+void RunLeafScanBenchmark();
+
+// raycastFirst/raycastAll cost per ray into a dense scene
+void RunRaycastBenchmark(int objectCount);
+
+// k-nearest and sphere query cost with reused output buffers
+void RunProximityBenchmark(int objectCount);
+
+// queryOverlappingPairs on 1..16 threads vs. one querySphere per object
+void RunOverlappingPairsBenchmark(int objectCount);
+
+// Frustum queries into a fresh vector, a reused vector, an IdSpan and a counting visitor
+void RunVisitorQueryBenchmark(int objectCount);
+
+// Bulk build vs. mapping a saved image, plus the first queries on the mapped tree
+void RunImageBenchmark(int objectCount);
+
+// Octree vs. BVH vs. hash grid build, query and move cost on uniform, mixed-size and
+// clustered scenes, and which of the Octree and BVH answered each scene's queries faster
+void RunIndexComparisonBenchmark(int objectCount);
+
+// Per-frame cost when every object moves, for each index, and when a tenth of the
+// objects move with and without handing them to a hash grid
+void RunDynamicSceneBenchmark(int objectCount, int frameCount);
+
+// Full frustum query per frame vs. queryFrustumChanges for a camera orbiting the scene
+// at a few speeds, with the number of visibility changes reported per frame
+void RunCoherentCullingBenchmark(int objectCount, int frameCount);
+
+// Frames that move a hundredth of the objects and then cull, run back to back vs. with
+// the culling of each frame on a worker thread, reading a ConcurrentOctree snapshot
+// while the main thread edits the next frame
+void RunConcurrentCullingBenchmark(int objectCount, int frameCount);
+
+// FlatSceneGraph update of deskCount desk subtrees under one root, serial vs. split across
+// the graph's persistent worker threads, with every world transform moving and with a hundredth of the desks moving;
+// checks that each thread count gives the serial result
+void RunSceneGraphBenchmark(int deskCount, int frameCount);
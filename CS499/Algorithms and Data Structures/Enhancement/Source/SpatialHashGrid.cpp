@@ -0,0 +1,328 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+const int SpatialHashGrid::kCellRange;
+const uint32_t SpatialHashGrid::kOutsideCell;
+const size_t SpatialHashGrid::kMinCellsBeforePrune;
+
+namespace {
+    // Spheres reach at most one cell edge past their own cell; the extra percent
+    // absorbs rounding in the cell bounds
+    const float kCellMargin = 1.01f;
+
+    // Cells four median diameters wide keep most per-frame moves inside one cell and
+    // hold a few dozen objects each, so queries visit few cells
+    const float kCellEdgeInMedianRadii = 8.0f;
+
+    const uint64_t kCoordMask = (1ull << 21) - 1;
+
+    bool insideBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+        return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+    }
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+    : m_cellSize(cellSize > 0.0f && std::isfinite(cellSize) ? cellSize : 1.0f) {
+    m_inverseCellSize = 1.0f / m_cellSize;
+    resetCellRange();
+}
+
+float SpatialHashGrid::cellSizeFor(const std::vector<SceneObject>& objects) {
+    std::vector<float> radii;
+    radii.reserve(objects.size());
+    for (const auto& obj : objects) {
+        if (obj.boundingRadius > 0.0f && std::isfinite(obj.boundingRadius)) radii.push_back(obj.boundingRadius);
+    }
+    if (radii.empty())
+        return 1.0f;
+    std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+    return kCellEdgeInMedianRadii * radii[radii.size() / 2];
+}
+
+void SpatialHashGrid::resetCellRange() {
+    m_cellMin = glm::ivec3(kCellRange);
+    m_cellMax = glm::ivec3(-kCellRange);
+}
+
+bool SpatialHashGrid::cellCoords(const glm::vec3& position, glm::ivec3& cell) const {
+    for (int axis = 0; axis < 3; ++axis) {
+        float coord = std::floor(position[axis] * m_inverseCellSize);
+        if (!(coord >= -kCellRange && coord < kCellRange))
+            return false; // Also rejects NaN
+        cell[axis] = static_cast<int>(coord);
+    }
+    return true;
+}
+
+uint64_t SpatialHashGrid::cellKey(const glm::ivec3& cell) {
+    return (static_cast<uint64_t>(cell.x + kCellRange) & kCoordMask) << 42 |
+           (static_cast<uint64_t>(cell.y + kCellRange) & kCoordMask) << 21 |
+           (static_cast<uint64_t>(cell.z + kCellRange) & kCoordMask);
+}
+
+bool SpatialHashGrid::fitsGrid(const SceneObject& obj, glm::ivec3& coords) const {
+    return obj.boundingRadius <= m_cellSize && cellCoords(obj.position, coords);
+}
+
+const SpatialHashGrid::Cell* SpatialHashGrid::findCell(const glm::ivec3& coords) const {
+    auto it = m_cellIndex.find(cellKey(coords));
+    return it != m_cellIndex.end() ? &m_cells[it->second] : nullptr;
+}
+
+uint32_t SpatialHashGrid::findOrAddCell(const glm::ivec3& coords) {
+    auto inserted = m_cellIndex.emplace(cellKey(coords), static_cast<uint32_t>(m_cells.size()));
+    if (inserted.second) {
+        m_cells.push_back(Cell{ coords, std::vector<SceneObject>() });
+        m_cellMin = glm::min(m_cellMin, coords);
+        m_cellMax = glm::max(m_cellMax, coords);
+    }
+    return inserted.first->second;
+}
+
+void SpatialHashGrid::clear() {
+    m_cells.clear();
+    m_cellIndex.clear();
+    m_outside.clear();
+    m_slots.clear();
+    resetCellRange();
+}
+
+void SpatialHashGrid::build(const std::vector<SceneObject>& objects, int) {
+    clear();
+    m_cellSize = cellSizeFor(objects);
+    m_inverseCellSize = 1.0f / m_cellSize;
+    m_slots.reserve(objects.size());
+    m_cellIndex.reserve(objects.size());
+    for (const auto& obj : objects) insert(obj);
+}
+
+void SpatialHashGrid::place(const SceneObject& obj) {
+    glm::ivec3 coords;
+    Slot slot;
+    slot.cell = fitsGrid(obj, coords) ? findOrAddCell(coords) : kOutsideCell;
+    std::vector<SceneObject>& objects = slotObjects(slot);
+    slot.index = static_cast<uint32_t>(objects.size());
+    objects.push_back(obj);
+    m_slots[obj.id] = slot;
+}
+
+void SpatialHashGrid::eraseSlot(const Slot& slot) {
+    std::vector<SceneObject>& objects = slotObjects(slot);
+    if (slot.index + 1 != objects.size()) {
+        objects[slot.index] = objects.back();
+        m_slots[objects[slot.index].id].index = slot.index;
+    }
+    objects.pop_back();
+}
+
+void SpatialHashGrid::pruneEmptyCells() {
+    std::vector<Cell> cells;
+    cells.reserve(m_slots.size());
+    m_cellIndex.clear();
+    resetCellRange();
+    for (auto& cell : m_cells) {
+        if (cell.objects.empty())
+            continue;
+        uint32_t index = static_cast<uint32_t>(cells.size());
+        m_cellIndex.emplace(cellKey(cell.coords), index);
+        m_cellMin = glm::min(m_cellMin, cell.coords);
+        m_cellMax = glm::max(m_cellMax, cell.coords);
+        for (const auto& obj : cell.objects) m_slots[obj.id].cell = index;
+        cells.push_back(std::move(cell));
+    }
+    m_cells.swap(cells);
+}
+
+void SpatialHashGrid::insert(const SceneObject& obj) {
+    remove(obj.id);
+    place(obj);
+    // Each prune leaves at most one cell per object, so it runs at most once per that many new cells
+    if (m_cells.size() > 2 * m_slots.size() + kMinCellsBeforePrune)
+        pruneEmptyCells();
+}
+
+void SpatialHashGrid::remove(int objectId) {
+    auto it = m_slots.find(objectId);
+    if (it == m_slots.end())
+        return;
+    Slot slot = it->second;
+    m_slots.erase(it);
+    eraseSlot(slot);
+}
+
+bool SpatialHashGrid::update(int objectId, const glm::vec3& newPosition, float newRadius) {
+    auto it = m_slots.find(objectId);
+    if (it == m_slots.end())
+        return false;
+
+    SceneObject moved{ newPosition, newRadius, objectId };
+    const Slot slot = it->second;
+    glm::ivec3 coords;
+    bool sameCell = fitsGrid(moved, coords) ? slot.cell != kOutsideCell && m_cells[slot.cell].coords == coords
+                                            : slot.cell == kOutsideCell;
+    if (sameCell) {
+        slotObjects(slot)[slot.index] = moved;
+        return true;
+    }
+    eraseSlot(slot);
+    place(moved);
+    if (m_cells.size() > 2 * m_slots.size() + kMinCellsBeforePrune)
+        pruneEmptyCells();
+    return true;
+}
+
+void SpatialHashGrid::query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const {
+    for (const auto& obj : m_outside) {
+        if (insideBox(obj.position, min, max)) results.push_back(obj.id);
+    }
+    if (m_cells.empty() || !(min.x <= max.x && min.y <= max.y && min.z <= max.z))
+        return;
+
+    glm::ivec3 first, last;
+    for (int axis = 0; axis < 3; ++axis) {
+        float low = std::floor(min[axis] * m_inverseCellSize);
+        float high = std::floor(max[axis] * m_inverseCellSize);
+        first[axis] = low > m_cellMax[axis] ? m_cellMax[axis] + 1 : low > m_cellMin[axis] ? static_cast<int>(low) : m_cellMin[axis];
+        last[axis] = high < m_cellMin[axis] ? m_cellMin[axis] - 1 : high < m_cellMax[axis] ? static_cast<int>(high) : m_cellMax[axis];
+        if (first[axis] > last[axis])
+            return;
+    }
+
+    // Cells strictly between the box's first and last cells on every axis are
+    // covered by the box, so their objects need no test
+    auto scanCell = [&](const glm::ivec3& cell, const std::vector<SceneObject>& objects) {
+        bool interior = glm::all(glm::greaterThan(cell, first)) && glm::all(glm::lessThan(cell, last));
+        for (const auto& obj : objects) {
+            if (interior || insideBox(obj.position, min, max)) results.push_back(obj.id);
+        }
+    };
+
+    // Walk the box's cells when there are fewer of them than occupied cells
+    double span = double(last.x - first.x + 1) * double(last.y - first.y + 1) * double(last.z - first.z + 1);
+    if (span <= static_cast<double>(m_cells.size())) {
+        glm::ivec3 cell;
+        for (cell.x = first.x; cell.x <= last.x; ++cell.x) {
+            for (cell.y = first.y; cell.y <= last.y; ++cell.y) {
+                for (cell.z = first.z; cell.z <= last.z; ++cell.z) {
+                    const Cell* occupied = findCell(cell);
+                    if (occupied) scanCell(cell, occupied->objects);
+                }
+            }
+        }
+        return;
+    }
+    for (const auto& cell : m_cells) {
+        if (glm::all(glm::greaterThanEqual(cell.coords, first)) && glm::all(glm::lessThanEqual(cell.coords, last)))
+            scanCell(cell.coords, cell.objects);
+    }
+}
+
+void SpatialHashGrid::queryFrustum(const Frustum& frustum, std::vector<int>& results) const {
+    for (const auto& obj : m_outside) {
+        if (frustum.intersectsSphere(obj.position, obj.boundingRadius)) results.push_back(obj.id);
+    }
+
+    const glm::vec3 margin(m_cellSize * kCellMargin);
+    for (const auto& cell : m_cells) {
+        const std::vector<SceneObject>& objects = cell.objects;
+        if (objects.empty())
+            continue;
+        glm::vec3 cellMin = glm::vec3(cell.coords) * m_cellSize;
+        switch (frustum.classifyBox(cellMin - margin, cellMin + glm::vec3(m_cellSize) + margin)) {
+        case Frustum::Outside:
+            break;
+        case Frustum::Inside:
+            for (const auto& obj : objects) results.push_back(obj.id);
+            break;
+        default:
+            for (const auto& obj : objects) {
+                if (frustum.intersectsSphere(obj.position, obj.boundingRadius)) results.push_back(obj.id);
+            }
+            break;
+        }
+    }
+}
+
+bool SpatialHashGrid::raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, float maxDistance) const {
+    float length = glm::length(direction);
+    if (!(length > 0.0f))
+        return false;
+    glm::vec3 dir = direction / length;
+
+    bool found = false;
+    float bestDistance = maxDistance;
+    auto testObjects = [&](const std::vector<SceneObject>& objects) {
+        for (const auto& obj : objects) {
+            float distance;
+            if (IntersectRaySphere(origin, dir, obj.position, obj.boundingRadius, bestDistance, distance) && (!found || distance < bestDistance)) {
+                found = true;
+                bestDistance = distance;
+                hit.id = obj.id;
+                hit.distance = distance;
+            }
+        }
+    };
+    testObjects(m_outside);
+    if (m_cells.empty())
+        return found;
+
+    // A hit point lies within one cell of the sphere's own cell, so the walk covers the
+    // occupied range plus one cell and checks each visited cell's neighbours
+    const glm::ivec3 walkMin = m_cellMin - glm::ivec3(1);
+    const glm::ivec3 walkMax = m_cellMax + glm::ivec3(1);
+    float entry;
+    if (!IntersectRayBox(origin, 1.0f / dir, glm::vec3(walkMin) * m_cellSize, glm::vec3(walkMax + glm::ivec3(1)) * m_cellSize, bestDistance, entry))
+        return found;
+
+    // 3D DDA from the entry point
+    glm::vec3 start = origin + dir * entry;
+    glm::ivec3 cell, step;
+    glm::vec3 nextCrossing, crossingStep;
+    for (int axis = 0; axis < 3; ++axis) {
+        float coord = std::floor(start[axis] * m_inverseCellSize);
+        cell[axis] = coord < walkMin[axis] ? walkMin[axis] : coord > walkMax[axis] ? walkMax[axis] : static_cast<int>(coord);
+        if (dir[axis] > 0.0f) {
+            step[axis] = 1;
+            nextCrossing[axis] = ((cell[axis] + 1) * m_cellSize - origin[axis]) / dir[axis];
+            crossingStep[axis] = m_cellSize / dir[axis];
+        } else if (dir[axis] < 0.0f) {
+            step[axis] = -1;
+            nextCrossing[axis] = (cell[axis] * m_cellSize - origin[axis]) / dir[axis];
+            crossingStep[axis] = -m_cellSize / dir[axis];
+        } else {
+            step[axis] = 0;
+            nextCrossing[axis] = std::numeric_limits<float>::infinity();
+            crossingStep[axis] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    // The first cell checks its whole neighbourhood; each step after that only adds the
+    // slab of neighbours on the side it moved toward
+    glm::ivec3 low(-1), high(1);
+    float cellEntry = entry;
+    while (cellEntry <= bestDistance) {
+        glm::ivec3 from = glm::max(cell + low, m_cellMin);
+        glm::ivec3 to = glm::min(cell + high, m_cellMax);
+        glm::ivec3 neighbour;
+        for (neighbour.x = from.x; neighbour.x <= to.x; ++neighbour.x) {
+            for (neighbour.y = from.y; neighbour.y <= to.y; ++neighbour.y) {
+                for (neighbour.z = from.z; neighbour.z <= to.z; ++neighbour.z) {
+                    const Cell* neighbourCell = findCell(neighbour);
+                    if (neighbourCell) testObjects(neighbourCell->objects);
+                }
+            }
+        }
+
+        int axis = nextCrossing.x < nextCrossing.y ? (nextCrossing.x < nextCrossing.z ? 0 : 2) : (nextCrossing.y < nextCrossing.z ? 1 : 2);
+        cellEntry = nextCrossing[axis];
+        cell[axis] += step[axis];
+        low = glm::ivec3(-1);
+        high = glm::ivec3(1);
+        low[axis] = high[axis] = step[axis];
+        if (cell[axis] < walkMin[axis] || cell[axis] > walkMax[axis])
+            break;
+        nextCrossing[axis] += crossingStep[axis];
+    }
+    return found;
+}
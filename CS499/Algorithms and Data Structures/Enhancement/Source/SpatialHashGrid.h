@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "SpatialIndex.h"
+
+/***********************************************************
+ *  SpatialHashGrid
+ *
+ *  Uniform grid of cubic cells, stored sparsely: occupied
+ *  cells sit in a flat list that a hash map indexes by cell
+ *  coordinates. Each object lives in the cell that holds
+ *  its center, so insert, move and remove are a hash lookup
+ *  and a swap-and-pop with no tree to rebalance, which suits
+ *  objects that move every frame.
+ *
+ *  The cell edge is eight times the median bounding radius
+ *  of the last build. Objects whose radius exceeds one cell, or
+ *  whose center is too far out for the cell coordinates,
+ *  are kept in a short list that every query scans.
+ ***********************************************************/
+class SpatialHashGrid : public SpatialIndex {
+public:
+    explicit SpatialHashGrid(float cellSize = 1.0f);
+
+    // Cell edge for a set of objects: eight times their median bounding radius
+    static float cellSizeFor(const std::vector<SceneObject>& objects);
+
+    // Re-picks the cell size from the objects, then hashes them in; threadCount is ignored
+    void build(const std::vector<SceneObject>& objects, int threadCount = 1) override;
+    void insert(const SceneObject& obj) override;
+    void remove(int objectId) override;
+    // Rewrites the entry in place while the center stays in its cell
+    bool update(int objectId, const glm::vec3& newPosition, float newRadius) override;
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const override;
+    void queryFrustum(const Frustum& frustum, std::vector<int>& results) const override;
+    bool raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                      float maxDistance = std::numeric_limits<float>::max()) const override;
+    void clear() override;
+    size_t size() const override { return m_slots.size(); }
+    bool contains(int objectId) const override { return m_slots.count(objectId) != 0; }
+    const char* name() const override { return "HashGrid"; }
+
+    float cellSize() const { return m_cellSize; }
+
+private:
+    static const int kCellRange = 1 << 20;        // Cell coordinates lie in [-kCellRange, kCellRange)
+    static const uint32_t kOutsideCell = 0xFFFFFFFFu; // Slot cell of objects kept in m_outside
+    static const size_t kMinCellsBeforePrune = 64;
+
+    struct Cell {
+        glm::ivec3 coords;
+        std::vector<SceneObject> objects;
+    };
+
+    struct Slot {
+        uint32_t cell;  // Index into m_cells, or kOutsideCell
+        uint32_t index; // Position in that cell's objects
+    };
+
+    float m_cellSize;
+    float m_inverseCellSize;
+    // Emptied cells keep their lists so objects moving back and forth do not reallocate;
+    // pruneEmptyCells drops them once they outnumber the objects
+    std::vector<Cell> m_cells;
+    std::unordered_map<uint64_t, uint32_t> m_cellIndex; // Cell key -> index into m_cells
+    std::vector<SceneObject> m_outside;                 // Too large or too far out for the grid
+    std::unordered_map<int, Slot> m_slots;
+    glm::ivec3 m_cellMin;                               // Range of cell coordinates in m_cells; min > max while empty
+    glm::ivec3 m_cellMax;
+
+    bool cellCoords(const glm::vec3& position, glm::ivec3& cell) const;
+    static uint64_t cellKey(const glm::ivec3& cell);
+    // False for objects that belong in m_outside
+    bool fitsGrid(const SceneObject& obj, glm::ivec3& coords) const;
+    const Cell* findCell(const glm::ivec3& coords) const;
+    uint32_t findOrAddCell(const glm::ivec3& coords);
+    std::vector<SceneObject>& slotObjects(const Slot& slot) { return slot.cell == kOutsideCell ? m_outside : m_cells[slot.cell].objects; }
+    void place(const SceneObject& obj);
+    void eraseSlot(const Slot& slot);
+    void pruneEmptyCells();
+    void resetCellRange();
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+struct SceneObject {
+    glm::vec3 position;
+    float boundingRadius;
+    int id; // Unique identifier
+};
+
+struct RayHit {
+    int id;
+    float distance; // Along the normalized ray; 0 when the ray starts inside the sphere
+};
+
+// Caller-owned, fixed-capacity output for visitor queries such as
+// Octree::query(min, max, F&&). Ids past the capacity are counted but not
+// stored, so a caller can tell the buffer was too small.
+struct IdSpan {
+    int* data;
+    size_t capacity;
+    size_t count; // Every id offered, including any that did not fit
+
+    IdSpan(int* buffer, size_t bufferCapacity) : data(buffer), capacity(bufferCapacity), count(0) {}
+
+    void operator()(int id) {
+        if (count < capacity) data[count] = id;
+        ++count;
+    }
+    size_t size() const { return count < capacity ? count : capacity; }
+    bool overflowed() const { return count > capacity; }
+    void clear() { count = 0; }
+    int* begin() const { return data; }
+    int* end() const { return data + size(); }
+};
+
+/***********************************************************
+ *  SpatialIndex
+ *
+ *  Common interface of the scene's spatial indexes (Octree,
+ *  BVH), so the scene and its registry can switch between
+ *  them. Every index answers the same queries with the same
+ *  results; only the result order may differ.
+ ***********************************************************/
+class SpatialIndex {
+public:
+    virtual ~SpatialIndex() {}
+
+    // Replace the contents with a batch of objects (ids must be unique). threadCount
+    // above 1 (0 = all hardware threads) lets an index build in parallel.
+    virtual void build(const std::vector<SceneObject>& objects, int threadCount = 1) = 0;
+    // Inserting an id that is already present replaces the old entry
+    virtual void insert(const SceneObject& obj) = 0;
+    virtual void remove(int objectId) = 0;
+    // Returns false for unknown ids
+    virtual bool update(int objectId, const glm::vec3& newPosition, float newRadius) = 0;
+    // Objects whose center lies inside the box [min, max]
+    virtual void query(const glm::vec3& min, const glm::vec3& max, std::vector<int>& results) const = 0;
+    // Objects whose bounding sphere touches the frustum
+    virtual void queryFrustum(const Frustum& frustum, std::vector<int>& results) const = 0;
+    // Nearest bounding sphere hit by origin + t * direction for 0 <= t <= maxDistance;
+    // returns false when nothing is hit
+    virtual bool raycastFirst(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                              float maxDistance = std::numeric_limits<float>::max()) const = 0;
+    virtual void clear() = 0;
+    virtual size_t size() const = 0;
+    virtual bool contains(int objectId) const = 0;
+    // Short name for logs and benchmark tables
+    virtual const char* name() const = 0;
+};
+
+// Entry distance of a normalized ray into a sphere, if it is at most maxDistance
+inline bool IntersectRaySphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius,
+                               float maxDistance, float& distance) {
+    glm::vec3 toCenter = center - origin;
+    float along = glm::dot(toCenter, direction);
+    float missSq = glm::dot(toCenter, toCenter) - along * along;
+    float radiusSq = radius * radius;
+    if (missSq > radiusSq)
+        return false;
+    float halfChord = std::sqrt(radiusSq - missSq);
+    if (along + halfChord < 0.0f)
+        return false; // Sphere is behind the origin
+    distance = std::max(along - halfChord, 0.0f);
+    return distance <= maxDistance;
+}
+
+// Slab test: distance at which a ray enters the box [min, max] (0 if it starts inside),
+// if it does so before maxDistance
+inline bool IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max,
+                            float maxDistance, float& entry) {
+    glm::vec3 t0 = (min - origin) * inverseDirection;
+    glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    if (enter > exit || enter > maxDistance)
+        return false;
+    entry = enter;
+    return true;
+}
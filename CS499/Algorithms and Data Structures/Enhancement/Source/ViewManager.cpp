@@ -14,6 +14,7 @@
 //   QE       - Move up/down
 //   Mouse    - Look around - pitch and yaw
 //   Scroll   - Adjust movement speed
+//   Click    - Pick the object under the screen center
 //   P        - Perspective projection mode
 //   O        - Orthographic projection mode
 //   ESC      - Exit application
@@ -73,6 +74,9 @@ namespace
     // Key press state tracking - prevents unwanted key repeat behavior
     bool pKeyPressed = false;                 // P key state for projection switching
     bool oKeyPressed = false;                 // O key state for projection switching
+
+    // Set by the mouse button callback, turned into a ray by PrepareSceneView
+    bool gPickRequested = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,6 +96,11 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
     // Store shader manager reference - used for sending matrices to GPU
     m_pShaderManager = pShaderManager;
     m_pWindow = nullptr;
+    m_view = glm::mat4(1.0f);
+    m_projection = glm::mat4(1.0f);
+    m_pickOrigin = glm::vec3(0.0f);
+    m_pickDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+    m_hasPickRay = false;
 
     // Create camera with optimal desk scene viewing position
     // REQUIREMENT 1: Position ensures all scene objects are captured
@@ -175,6 +184,7 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     // Register input callback functions for navigation
     glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
     glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
+    glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
 
     // Enable depth testing for proper 3D rendering
     glEnable(GL_DEPTH_TEST);
@@ -268,6 +278,45 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, doub
         << gCameraSpeed << " (Range: " << gMinCameraSpeed << " - " << gMaxCameraSpeed << ")" << std::endl;
 }
 
+/**
+ * Static callback function for mouse button events
+ * PURPOSE: Request object picking on left click
+ * The cursor is captured for mouse look, so picks go through the screen
+ * center; the ray itself is built in PrepareSceneView from the new matrices
+ *
+ * @param window - GLFW window that received the event (unused)
+ * @param button - Mouse button that changed state
+ * @param action - GLFW_PRESS or GLFW_RELEASE
+ * @param mods - Modifier keys held (unused)
+ */
+void ViewManager::Mouse_Button_Callback(GLFWwindow* /*window*/, int button, int action, int /*mods*/)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    {
+        gPickRequested = true;
+    }
+}
+
+/**
+ * Returns the picking ray for the last click, once
+ * PURPOSE: Let the render loop run the scene query without knowing about input
+ *
+ * @param origin - Receives the ray start on the near plane
+ * @param direction - Receives the normalized ray direction
+ * @return true when a click was waiting
+ */
+bool ViewManager::ConsumePickRay(glm::vec3& origin, glm::vec3& direction)
+{
+    if (!m_hasPickRay)
+    {
+        return false;
+    }
+    origin = m_pickOrigin;
+    direction = m_pickDirection;
+    m_hasPickRay = false;
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // KEYBOARD INPUT HANDLING - REQUIREMENT 1 & 3
 ///////////////////////////////////////////////////////////////////////////////
@@ -444,6 +493,23 @@ void ViewManager::PrepareSceneView()
         );
     }
 
+    // Keep the matrices for frustum culling on the CPU side
+    m_view = view;
+    m_projection = projection;
+
+    // Unproject the screen center on the near and far planes; works for both
+    // perspective and orthographic projections
+    if (gPickRequested)
+    {
+        const glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+        glm::vec4 nearPoint = inverseViewProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+        glm::vec4 farPoint = inverseViewProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        m_pickOrigin = glm::vec3(nearPoint) / nearPoint.w;
+        m_pickDirection = glm::normalize(glm::vec3(farPoint) / farPoint.w - m_pickOrigin);
+        m_hasPickRay = true;
+        gPickRequested = false;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // SHADER UNIFORM UPDATES - Send matrices to GPU
     ///////////////////////////////////////////////////////////////////////////
@@ -27,11 +27,21 @@ public:
 	// mouse scroll callback for adjusting camera movement speed
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
 
+	// mouse button callback; a left click requests a pick through the screen center
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// matrices from the last PrepareSceneView call (used for culling)
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	// world-space picking ray built by PrepareSceneView after a click
+	glm::vec3 m_pickOrigin;
+	glm::vec3 m_pickDirection;
+	bool m_hasPickRay;
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
 
@@ -41,4 +51,11 @@ public:
 
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// view and projection matrices sent to the shader by PrepareSceneView
+	const glm::mat4& GetViewMatrix() const { return m_view; }
+	const glm::mat4& GetProjectionMatrix() const { return m_projection; }
+
+	// hand out the ray for the last click once; false when no click is pending
+	bool ConsumePickRay(glm::vec3& origin, glm::vec3& direction);
 };
\ No newline at end of file